@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Checks the in-place guarantee of ddaf_forward and ddaf_backward: for
+ * every activation type and architecture, with and without a saved input,
+ * a call with output == input gives the same floats, bit for bit, as the
+ * same call on separate buffers. Elements a call does not write keep their
+ * old values in both runs, so whole buffers are compared.
+ */
+
+#include "ddaf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SIZE 64
+#define N_ITERATIONS 4
+
+static int init_arch(ddaf_context_t* ctx, ddaf_arch_t arch) {
+    switch (arch) {
+        case DDAF_ARCH_CNN:
+            return ddaf_cnn_init(ctx, 4, 4, 4);
+        case DDAF_ARCH_RNN:
+            return ddaf_rnn_init(ctx, 48, 8);
+        case DDAF_ARCH_LSTM:
+            return ddaf_lstm_init(ctx, SIZE / 4, 8);
+        case DDAF_ARCH_GRU:
+            return ddaf_gru_init(ctx, SIZE / 4, 8);
+        case DDAF_ARCH_TRANSFORMER:
+            return ddaf_transformer_init(ctx, 16, 4, 4);
+        case DDAF_ARCH_HIERARCHICAL_TRANSFORMER:
+            return ddaf_hierarchical_transformer_init(ctx, 16, 4, 2);
+        case DDAF_ARCH_BIGBIRD:
+            return ddaf_bigbird_init(ctx, 16, 4, 4, 2);
+        case DDAF_ARCH_MOE:
+            return ddaf_moe_init(ctx, SIZE, 8, 2);
+    }
+    return -1;
+}
+
+static ddaf_context_t* create(ddaf_type_t type, ddaf_arch_t arch,
+                              ddaf_save_policy_t policy) {
+    ddaf_context_t* ctx = ddaf_create_context(type, arch, 0);
+    if (!ctx) return NULL;
+    
+    if (init_arch(ctx, arch) != 0 ||
+        ddaf_set_save_policy(ctx, policy) != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/*
+ * Forward and backward a few times on two identical contexts, one in place
+ * and one on separate buffers. Returns the number of mismatching passes,
+ * or -1 if a context or call fails.
+ */
+static int check(ddaf_type_t type, ddaf_arch_t arch,
+                 ddaf_save_policy_t policy) {
+    ddaf_context_t* aliased = create(type, arch, policy);
+    ddaf_context_t* separate = create(type, arch, policy);
+    if (!aliased || !separate) {
+        ddaf_destroy_context(aliased);
+        ddaf_destroy_context(separate);
+        return -1;
+    }
+    
+    float input[SIZE];
+    float output[SIZE];
+    float buffer[SIZE];
+    int mismatches = 0;
+    int ret = 0;
+    
+    for (int it = 0; it < N_ITERATIONS && ret == 0; it++) {
+        for (size_t i = 0; i < SIZE; i++) {
+            input[i] = 2.0f * sinf(0.37f * (float)i + (float)it);
+        }
+        
+        memcpy(output, input, sizeof(input));
+        memcpy(buffer, input, sizeof(input));
+        ret |= ddaf_forward(separate, input, output, SIZE);
+        ret |= ddaf_forward(aliased, buffer, buffer, SIZE);
+        mismatches += memcmp(output, buffer, sizeof(output)) != 0;
+        
+        /* Gradient of the forward output, as a training step would pass */
+        memcpy(input, output, sizeof(output));
+        memcpy(buffer, output, sizeof(output));
+        ret |= ddaf_backward(separate, input, output, SIZE);
+        ret |= ddaf_backward(aliased, buffer, buffer, SIZE);
+        mismatches += memcmp(output, buffer, sizeof(output)) != 0;
+    }
+    
+    ddaf_destroy_context(aliased);
+    ddaf_destroy_context(separate);
+    return ret != 0 ? -1 : mismatches;
+}
+
+int main() {
+    const char* types[] = { "data-driven", "dynamic", "online", "attention" };
+    const char* archs[] = { "cnn", "rnn", "lstm", "gru", "transformer",
+                            "hierarchical", "bigbird", "moe" };
+    ddaf_save_policy_t policies[] = { DDAF_SAVE_NONE, DDAF_SAVE_INPUT };
+    
+    printf("%12s %14s %12s %12s\n", "type", "architecture", "no saving",
+           "saved input");
+    
+    int failures = 0;
+    for (int t = DDAF_TYPE_DATA_DRIVEN; t <= DDAF_TYPE_ATTENTION; t++) {
+        for (int a = DDAF_ARCH_CNN; a <= DDAF_ARCH_MOE; a++) {
+            const char* results[2];
+            for (size_t p = 0; p < 2; p++) {
+                int mismatches = check((ddaf_type_t)t, (ddaf_arch_t)a,
+                                       policies[p]);
+                results[p] = mismatches == 0 ? "ok" :
+                             mismatches < 0 ? "ERROR" : "MISMATCH";
+                failures += mismatches != 0;
+            }
+            printf("%12s %14s %12s %12s\n", types[t], archs[a], results[0],
+                   results[1]);
+        }
+    }
+    
+    printf("\n%s\n", failures ? "FAILED" : "All checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Batched calls against a loop of ddaf_forward and ddaf_backward over the
+ * samples, for the elementwise types and an LSTM step, with a check that
+ * per-sample statistics give the loop's output bit for bit. Samples this
+ * small run inline one by one; a batch is large enough to use the threads.
+ */
+
+#include "ddaf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH 256
+#define SAMPLE_SIZE 512
+#define HIDDEN_SIZE 128
+#define N_ITERATIONS 20
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static ddaf_context_t* create(ddaf_type_t type, ddaf_arch_t arch) {
+    ddaf_context_t* ctx = ddaf_create_context(type, arch, 0);
+    if (!ctx) return NULL;
+    
+    int ret = -1;
+    if (arch == DDAF_ARCH_LSTM) {
+        ret = ddaf_lstm_init(ctx, HIDDEN_SIZE, 1);
+    } else if (type == DDAF_TYPE_DATA_DRIVEN) {
+        ret = ddaf_init_data_driven(ctx, SAMPLE_SIZE);
+    } else if (type == DDAF_TYPE_DYNAMIC) {
+        ret = ddaf_init_dynamic(ctx, SAMPLE_SIZE);
+    } else if (type == DDAF_TYPE_ONLINE) {
+        ret = ddaf_init_online(ctx, SAMPLE_SIZE);
+    }
+    if (ret != 0 || ddaf_set_save_policy(ctx, DDAF_SAVE_INPUT) != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/* Milliseconds per forward and backward step of one batch */
+static double run_loop(ddaf_context_t* ctx, const float* input, float* output,
+                       float* grad) {
+    double start = now_seconds();
+    for (int it = 0; it < N_ITERATIONS; it++) {
+        for (size_t b = 0; b < BATCH; b++) {
+            size_t offset = b * SAMPLE_SIZE;
+            ddaf_forward(ctx, input + offset, output + offset, SAMPLE_SIZE);
+            ddaf_backward(ctx, output + offset, grad + offset, SAMPLE_SIZE);
+        }
+    }
+    return (now_seconds() - start) / N_ITERATIONS * 1e3;
+}
+
+static double run_batched(ddaf_context_t* ctx, const float* input,
+                          float* output, float* grad, unsigned flags) {
+    double start = now_seconds();
+    for (int it = 0; it < N_ITERATIONS; it++) {
+        ddaf_forward_batched(ctx, input, output, BATCH, SAMPLE_SIZE, flags);
+        ddaf_backward_batched(ctx, output, grad, BATCH, SAMPLE_SIZE, flags);
+    }
+    return (now_seconds() - start) / N_ITERATIONS * 1e3;
+}
+
+int main() {
+    size_t size = (size_t)BATCH * SAMPLE_SIZE;
+    const char* names[] = { "data-driven", "dynamic", "online", "lstm" };
+    ddaf_type_t types[] = { DDAF_TYPE_DATA_DRIVEN, DDAF_TYPE_DYNAMIC,
+                            DDAF_TYPE_ONLINE, DDAF_TYPE_DATA_DRIVEN };
+    ddaf_arch_t archs[] = { DDAF_ARCH_CNN, DDAF_ARCH_CNN, DDAF_ARCH_CNN,
+                            DDAF_ARCH_LSTM };
+    
+    float* input = (float*)malloc(size * sizeof(float));
+    float* output = (float*)calloc(size, sizeof(float));
+    float* grad = (float*)calloc(size, sizeof(float));
+    float* reference = (float*)calloc(size, sizeof(float));
+    if (!input || !output || !grad || !reference) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(output);
+        free(grad);
+        free(reference);
+        return 1;
+    }
+    
+    srand(29);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 4.0f - 2.0f;
+    }
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t thread_counts[] = { 1, cpus > 4 ? (size_t)cpus : 4 };
+    
+    printf("%d samples of %d floats, forward + backward\n\n", BATCH,
+           SAMPLE_SIZE);
+    printf("%12s %8s %10s %12s %12s %10s %10s\n", "type", "threads",
+           "loop ms", "per-sample", "shared ms", "speedup", "identical");
+    
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        for (size_t n = 0; n < 2; n++) {
+            if (ddaf_set_num_threads(thread_counts[n]) != 0) {
+                fprintf(stderr, "Failed to start %zu threads\n",
+                        thread_counts[n]);
+                break;
+            }
+            
+            ddaf_context_t* loop = create(types[t], archs[t]);
+            ddaf_context_t* per_sample = create(types[t], archs[t]);
+            ddaf_context_t* shared = create(types[t], archs[t]);
+            if (!loop || !per_sample || !shared) {
+                fprintf(stderr, "Failed to create %s context\n", names[t]);
+                ddaf_destroy_context(loop);
+                ddaf_destroy_context(per_sample);
+                ddaf_destroy_context(shared);
+                break;
+            }
+            
+            double loop_ms = run_loop(loop, input, reference, grad);
+            double per_sample_ms = run_batched(per_sample, input, output,
+                                               grad, DDAF_BATCH_PER_SAMPLE);
+            double shared_ms = run_batched(shared, input, output, grad,
+                                           DDAF_BATCH_SHARED);
+            
+            /*
+             * The loop gives an LSTM one state for all samples, the batched
+             * call one per sample, so only the elementwise types compare
+             */
+            const char* identical = "-";
+            if (archs[t] == DDAF_ARCH_CNN) {
+                ddaf_forward_batched(per_sample, input, output, BATCH,
+                                     SAMPLE_SIZE, DDAF_BATCH_PER_SAMPLE);
+                for (size_t b = 0; b < BATCH; b++) {
+                    size_t offset = b * SAMPLE_SIZE;
+                    ddaf_forward(loop, input + offset, reference + offset,
+                                 SAMPLE_SIZE);
+                }
+                identical = memcmp(reference, output,
+                                   size * sizeof(float)) == 0 ? "yes" : "NO";
+            }
+            
+            printf("%12s %8zu %10.3f %12.3f %12.3f %9.2fx %10s\n", names[t],
+                   thread_counts[n], loop_ms, per_sample_ms, shared_ms,
+                   loop_ms / per_sample_ms, identical);
+            
+            ddaf_destroy_context(loop);
+            ddaf_destroy_context(per_sample);
+            ddaf_destroy_context(shared);
+        }
+    }
+    
+    ddaf_set_num_threads(1);
+    
+    free(input);
+    free(output);
+    free(grad);
+    free(reference);
+    
+    return 0;
+}
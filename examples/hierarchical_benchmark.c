@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Level-count scaling of the hierarchical transformer: the levels now chain
+ * through the caller's output in place, versus the former copy of the whole
+ * tensor between levels
+ */
+
+#include "ddaf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define D_MODEL 512
+#define SEQ_LEN 2048
+#define MAX_LEVELS 6
+#define N_ITERATIONS 10
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * The level loop the forward pass used before: copy in, copy after each
+ * level. Returns the bytes its copies read and wrote.
+ */
+static size_t copying_forward(ddaf_context_t* ctx, const float* input,
+                              float* output, float* temp, size_t size) {
+    size_t bytes = size * sizeof(float);
+    memcpy(temp, input, bytes);
+    size_t copied = 2 * bytes;
+    
+    for (ddaf_context_t* level = ctx->first_child; level;
+         level = level->next_sibling) {
+        ddaf_forward(level, temp, output, size);
+        if (level->next_sibling) {
+            memcpy(temp, output, bytes);
+            copied += 2 * bytes;
+        }
+    }
+    return copied;
+}
+
+/*
+ * Bytes the chained forward copies: the first level writes output from
+ * input, so it only copies input to output when no level runs
+ */
+static size_t chained_copy_bytes(const ddaf_context_t* ctx,
+                                 const float* input, const float* output,
+                                 size_t size) {
+    if (ctx->first_child || input == output) return 0;
+    return 2 * size * sizeof(float);
+}
+
+int main() {
+    size_t size = (size_t)D_MODEL * SEQ_LEN;
+    double mb = (double)size * sizeof(float) / (1 << 20);
+    
+    float* input = (float*)malloc(size * sizeof(float));
+    float* output = (float*)malloc(size * sizeof(float));
+    float* temp = (float*)malloc(size * sizeof(float));
+    if (!input || !output || !temp) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(output);
+        free(temp);
+        return 1;
+    }
+    
+    srand(11);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 4.0f - 2.0f;
+    }
+    
+    printf("Hierarchical transformer, %d x %d input (%.1f MB)\n\n",
+           D_MODEL, SEQ_LEN, mb);
+    printf("%7s %12s %12s %12s %12s %12s %12s %12s\n", "levels",
+           "copying MB", "chained MB", "copying ms", "chained ms", "ms/level",
+           "bwd ms", "scratch B");
+    
+    for (size_t n_levels = 1; n_levels <= MAX_LEVELS; n_levels++) {
+        ddaf_context_t* ctx = ddaf_create_context(DDAF_TYPE_DATA_DRIVEN,
+                                                  DDAF_ARCH_HIERARCHICAL_TRANSFORMER,
+                                                  0);
+        if (!ctx || ddaf_hierarchical_transformer_init(ctx, D_MODEL, 8,
+                                                       n_levels) != 0) {
+            fprintf(stderr, "Failed to initialize %zu levels\n", n_levels);
+            ddaf_destroy_context(ctx);
+            continue;
+        }
+        
+        /* Warm up both paths, counting what each copies per forward */
+        size_t copying_bytes = copying_forward(ctx, input, output, temp,
+                                               size);
+        ddaf_forward(ctx, input, output, size);
+        size_t chained_bytes = chained_copy_bytes(ctx, input, output, size);
+        
+        double start = now_seconds();
+        for (int it = 0; it < N_ITERATIONS; it++) {
+            copying_forward(ctx, input, output, temp, size);
+        }
+        double copying_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+        
+        start = now_seconds();
+        for (int it = 0; it < N_ITERATIONS; it++) {
+            ddaf_forward(ctx, input, output, size);
+        }
+        double chained_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+        
+        start = now_seconds();
+        for (int it = 0; it < N_ITERATIONS; it++) {
+            ddaf_backward(ctx, input, output, size);
+        }
+        double backward_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+        
+        /* Copy traffic per forward, read + write */
+        printf("%7zu %12.1f %12.1f %12.3f %12.3f %12.3f %12.3f %12zu\n",
+               n_levels, (double)copying_bytes / (1 << 20),
+               (double)chained_bytes / (1 << 20), copying_ms, chained_ms,
+               chained_ms / n_levels, backward_ms,
+               ddaf_forward_workspace_size(ctx, size) +
+               ddaf_backward_workspace_size(ctx, size));
+        
+        ddaf_destroy_context(ctx);
+    }
+    
+    free(input);
+    free(output);
+    free(temp);
+    
+    return 0;
+}
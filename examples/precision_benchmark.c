@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ * 
+ * Error-vs-throughput report for the precision tiers
+ */
+
+#include "ddaf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define N_ITERATIONS 50
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static const char* tier_name(ddaf_precision_t precision) {
+    switch (precision) {
+        case DDAF_PRECISION_EXACT:   return "exact";
+        case DDAF_PRECISION_FAST:    return "fast";
+        case DDAF_PRECISION_FASTEST: return "fastest";
+        default:                     return "?";
+    }
+}
+
+static const char* type_name(ddaf_type_t type) {
+    switch (type) {
+        case DDAF_TYPE_DATA_DRIVEN: return "data-driven";
+        case DDAF_TYPE_DYNAMIC:     return "dynamic";
+        case DDAF_TYPE_ONLINE:      return "online";
+        case DDAF_TYPE_ATTENTION:   return "attention";
+        default:                    return "?";
+    }
+}
+
+/* CNN layer of 64 channels x 32 x 32, run once per tier */
+static int run_tier(ddaf_type_t type, ddaf_precision_t precision,
+                    const float* input, float* output, size_t size,
+                    double* seconds) {
+    ddaf_context_t* ctx = ddaf_create_context(type, DDAF_ARCH_CNN, 0);
+    if (!ctx) return -1;
+    
+    if (ddaf_set_precision(ctx, precision) != 0 ||
+        ddaf_cnn_init(ctx, 64, 32, 32) != 0) {
+        ddaf_destroy_context(ctx);
+        return -1;
+    }
+    
+    /* First call is the reference output; the timed calls follow */
+    int ret = ddaf_forward(ctx, input, output, size);
+    
+    double start = now_seconds();
+    float* scratch = (float*)malloc(size * sizeof(float));
+    for (int it = 0; it < N_ITERATIONS && ret == 0 && scratch; it++) {
+        ret = ddaf_forward(ctx, input, scratch, size);
+    }
+    *seconds = (now_seconds() - start) / N_ITERATIONS;
+    
+    free(scratch);
+    ddaf_destroy_context(ctx);
+    return ret;
+}
+
+int main() {
+    size_t size = 64 * 32 * 32;
+    float* input = (float*)malloc(size * sizeof(float));
+    float* reference = (float*)malloc(size * sizeof(float));
+    float* output = (float*)malloc(size * sizeof(float));
+    
+    if (!input || !reference || !output) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(reference);
+        free(output);
+        return 1;
+    }
+    
+    srand(42);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 8.0f - 4.0f;
+    }
+    
+    printf("ISA level: %d, CNN 64x32x32 (%zu elements)\n", 
+           (int)ddaf_get_isa(), size);
+    printf("%-12s %-8s %14s %14s %10s\n", 
+           "type", "tier", "max abs err", "Melem/s", "speedup");
+    
+    ddaf_type_t types[] = { DDAF_TYPE_DATA_DRIVEN, DDAF_TYPE_DYNAMIC,
+                            DDAF_TYPE_ONLINE };
+    
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        double exact_seconds = 0.0;
+        
+        for (int p = DDAF_PRECISION_EXACT; p <= DDAF_PRECISION_FASTEST; p++) {
+            double seconds = 0.0;
+            float* dst = (p == DDAF_PRECISION_EXACT) ? reference : output;
+            
+            if (run_tier(types[t], (ddaf_precision_t)p, input, dst, size,
+                         &seconds) != 0) {
+                fprintf(stderr, "%s/%s forward failed\n", type_name(types[t]),
+                        tier_name((ddaf_precision_t)p));
+                continue;
+            }
+            
+            double max_err = 0.0;
+            if (p == DDAF_PRECISION_EXACT) {
+                exact_seconds = seconds;
+            } else {
+                for (size_t i = 0; i < size; i++) {
+                    double err = fabs((double)output[i] - (double)reference[i]);
+                    if (err > max_err) max_err = err;
+                }
+            }
+            
+            printf("%-12s %-8s %14.3e %14.1f %9.2fx\n", type_name(types[t]),
+                   tier_name((ddaf_precision_t)p), max_err,
+                   (double)size / seconds * 1e-6, exact_seconds / seconds);
+        }
+    }
+    
+    free(input);
+    free(reference);
+    free(output);
+    
+    return 0;
+}
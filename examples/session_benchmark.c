@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Serving one model from several threads: the bytes a session allocates
+ * against a full copy of the model, and inference throughput with one
+ * session per thread, checked against a single-threaded run
+ */
+
+#include "ddaf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define D_MODEL 512
+#define SEQ_LEN 256
+#define N_PARAMS (D_MODEL * SEQ_LEN)
+#define N_SEGMENTS 4096
+#define N_ITERATIONS 20
+#define MAX_THREADS 8
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Counts every byte allocated through the context options, on any thread */
+static void* counting_malloc(size_t size, void* user_data) {
+    atomic_fetch_add((atomic_size_t*)user_data, size);
+    return malloc(size);
+}
+
+static void counting_free(void* ptr, void* user_data) {
+    (void)user_data;
+    free(ptr);
+}
+
+static ddaf_context_t* create_model(ddaf_type_t type, atomic_size_t* counter) {
+    ddaf_context_options_t options;
+    ddaf_context_options_init(&options);
+    options.pool_size = 0;
+    options.allocator.malloc_fn = counting_malloc;
+    options.allocator.free_fn = counting_free;
+    options.allocator.user_data = counter;
+    
+    ddaf_context_t* ctx = ddaf_create_context_ex(type, DDAF_ARCH_CNN, 0,
+                                                 &options);
+    if (!ctx) return NULL;
+    
+    int ret = -1;
+    if (type == DDAF_TYPE_DATA_DRIVEN) {
+        ret = ddaf_init_data_driven(ctx, N_PARAMS);
+    } else if (type == DDAF_TYPE_DYNAMIC) {
+        ret = ddaf_init_dynamic(ctx, N_PARAMS);
+    } else if (type == DDAF_TYPE_ATTENTION) {
+        ret = ddaf_init_attention(ctx, D_MODEL, 8, SEQ_LEN);
+    }
+    
+    /* Frozen for inference; attention has no tables and stays exact */
+    if (ret == 0 && type != DDAF_TYPE_ATTENTION) {
+        ret = ddaf_bake(ctx, -16.0f, 16.0f, N_SEGMENTS, DDAF_INTERP_CUBIC);
+    }
+    if (ret != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+typedef struct {
+    ddaf_session_t* session;
+    const float* input;
+    float* output;
+    int status;
+} serve_t;
+
+static void* serve(void* arg) {
+    serve_t* job = (serve_t*)arg;
+    size_t size = (size_t)D_MODEL * SEQ_LEN;
+    
+    job->status = 0;
+    for (int it = 0; it < N_ITERATIONS; it++) {
+        if (ddaf_session_forward(job->session, job->input, job->output,
+                                 size) != 0) {
+            job->status = -1;
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    size_t size = (size_t)D_MODEL * SEQ_LEN;
+    const char* names[] = { "data-driven", "dynamic", "attention" };
+    ddaf_type_t types[] = { DDAF_TYPE_DATA_DRIVEN, DDAF_TYPE_DYNAMIC,
+                            DDAF_TYPE_ATTENTION };
+    
+    float* input = (float*)malloc(size * sizeof(float));
+    float* reference = (float*)malloc(size * sizeof(float));
+    float* outputs = (float*)malloc(MAX_THREADS * size * sizeof(float));
+    if (!input || !reference || !outputs) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(reference);
+        free(outputs);
+        return 1;
+    }
+    
+    srand(41);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 4.0f - 2.0f;
+    }
+    
+    printf("%d x %d activation, %d forward calls per thread\n\n", D_MODEL,
+           SEQ_LEN, N_ITERATIONS);
+    printf("%12s %12s %12s %8s %12s %10s\n", "type", "model KB",
+           "session KB", "threads", "calls/s", "identical");
+    
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        atomic_size_t allocated = 0;
+        ddaf_context_t* model = create_model(types[t], &allocated);
+        if (!model) {
+            fprintf(stderr, "Failed to create %s model\n", names[t]);
+            break;
+        }
+        size_t model_bytes = atomic_load(&allocated);
+        
+        /* Pools start empty, so this is the state a session copies */
+        ddaf_session_t* probe = ddaf_create_session(model);
+        size_t session_bytes = atomic_load(&allocated) - model_bytes;
+        ddaf_destroy_session(probe);
+        
+        for (size_t n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2) {
+            serve_t jobs[MAX_THREADS];
+            pthread_t threads[MAX_THREADS];
+            size_t started = 0;
+            
+            double start = now_seconds();
+            for (; started < n_threads; started++) {
+                serve_t* job = &jobs[started];
+                job->session = ddaf_create_session(model);
+                job->input = input;
+                job->output = outputs + started * size;
+                if (!job->session ||
+                    pthread_create(&threads[started], NULL, serve, job) != 0) {
+                    ddaf_destroy_session(job->session);
+                    break;
+                }
+            }
+            
+            bool identical = started == n_threads;
+            for (size_t i = 0; i < started; i++) {
+                pthread_join(threads[i], NULL);
+                identical = identical && jobs[i].status == 0;
+            }
+            double seconds = now_seconds() - start;
+            
+            /* Outputs depend only on the input, so every session agrees */
+            for (size_t i = 0; i < started; i++) {
+                if (n_threads == 1) {
+                    memcpy(reference, jobs[i].output, size * sizeof(float));
+                } else if (memcmp(reference, jobs[i].output,
+                                  size * sizeof(float)) != 0) {
+                    identical = false;
+                }
+                ddaf_destroy_session(jobs[i].session);
+            }
+            
+            printf("%12s %12.1f %12.1f %8zu %12.1f %10s\n", names[t],
+                   model_bytes / 1024.0, session_bytes / 1024.0, n_threads,
+                   started * N_ITERATIONS / seconds, identical ? "yes" : "NO");
+        }
+        
+        ddaf_destroy_context(model);
+    }
+    
+    free(input);
+    free(reference);
+    free(outputs);
+    
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ * 
+ * Memory traffic of the data-driven statistics: legacy two-pass
+ * mean/variance versus the blocked single-sweep reduction
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define N_ITERATIONS 10
+
+/*
+ * Passes over the tensor that stream from memory, per the loops timed
+ * below. The second read of each statistics block in the blocked sweep is
+ * served from L1 and does not count.
+ */
+#define LEGACY_STAT_PASSES 2    /* legacy_moments: mean, then variance */
+#define FUSED_STAT_PASSES 1     /* ddaf_moments_compute: one blocked sweep */
+#define ACTIVATION_PASSES 2     /* Normalize-and-activate: read, store */
+
+/* Keeps the timed reductions from being optimized away */
+static volatile float sink;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* The statistics loop data_driven_forward used before the blocked sweep */
+static void legacy_moments(const float* input, size_t size,
+                           float* mean_out, float* variance_out) {
+    float mean = 0.0f;
+    float variance = 0.0f;
+    
+    for (size_t i = 0; i < size; i++) {
+        mean += input[i];
+    }
+    mean /= size;
+    
+    for (size_t i = 0; i < size; i++) {
+        float diff = input[i] - mean;
+        variance += diff * diff;
+    }
+    variance /= size;
+    
+    *mean_out = mean;
+    *variance_out = variance;
+}
+
+int main() {
+    size_t sizes[] = { 1 << 16, 1 << 20, 1 << 22, 1 << 24 };
+    size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    
+    float* input = (float*)malloc(max_size * sizeof(float));
+    float* output = (float*)malloc(max_size * sizeof(float));
+    if (!input || !output) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(output);
+        return 1;
+    }
+    
+    srand(7);
+    for (size_t i = 0; i < max_size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 2.0f + 3.0f;
+    }
+    
+    /* Modeled from the pass counts, not measured */
+    printf("Modeled DRAM bytes/element: legacy %zu, fused %zu\n\n",
+           (LEGACY_STAT_PASSES + ACTIVATION_PASSES) * sizeof(float),
+           (FUSED_STAT_PASSES + ACTIVATION_PASSES) * sizeof(float));
+    printf("%10s %8s %12s %11s %8s %11s %11s %9s\n", "elements", "MB",
+           "legacy GB/s", "fused GB/s", "speedup", "legacy err", "fused err",
+           "fwd ms");
+    
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+        double bytes = (double)size * sizeof(float);
+        
+        float legacy_mean = 0.0f;
+        float legacy_var = 0.0f;
+        double start = now_seconds();
+        for (int it = 0; it < N_ITERATIONS; it++) {
+            legacy_moments(input, size, &legacy_mean, &legacy_var);
+            sink = legacy_var;
+        }
+        double legacy_time = (now_seconds() - start) / N_ITERATIONS;
+        
+        ddaf_moments_t moments;
+        start = now_seconds();
+        for (int it = 0; it < N_ITERATIONS; it++) {
+            ddaf_moments_compute(input, size, &moments);
+            sink = (float)moments.m2;
+        }
+        double fused_time = (now_seconds() - start) / N_ITERATIONS;
+        
+        /* Reference variance in double precision */
+        double ref_mean = 0.0, ref_m2 = 0.0;
+        for (size_t i = 0; i < size; i++) ref_mean += input[i];
+        ref_mean /= size;
+        for (size_t i = 0; i < size; i++) {
+            ref_m2 += (input[i] - ref_mean) * (input[i] - ref_mean);
+        }
+        double ref_var = ref_m2 / size;
+        double legacy_err = fabs(legacy_var - ref_var) / ref_var;
+        double fused_err = fabs(moments.m2 / size - ref_var) / ref_var;
+        
+        /* Whole forward pass on a data-driven context */
+        ddaf_context_t* ctx = ddaf_create_context(DDAF_TYPE_DATA_DRIVEN,
+                                                  DDAF_ARCH_CNN, 0);
+        double forward_ms = -1.0;
+        if (ctx && ddaf_init_data_driven(ctx, 1024) == 0) {
+            start = now_seconds();
+            for (int it = 0; it < N_ITERATIONS; it++) {
+                ddaf_forward(ctx, input, output, size);
+            }
+            forward_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+        }
+        ddaf_destroy_context(ctx);
+        
+        /* Effective bandwidth of the statistics phase over modeled traffic */
+        printf("%10zu %8.1f %12.2f %11.2f %7.2fx %11.2e %11.2e %9.3f\n", size,
+               bytes / (1 << 20),
+               LEGACY_STAT_PASSES * bytes / legacy_time * 1e-9,
+               FUSED_STAT_PASSES * bytes / fused_time * 1e-9,
+               legacy_time / fused_time, legacy_err, fused_err, forward_ms);
+    }
+    
+    free(input);
+    free(output);
+    
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * 16-bit storage: forward passes over float, fp16 and bf16 tensors for
+ * the data-driven, dynamic and online types
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define N_ELEMENTS (1 << 24)
+#define N_PARAMS 1024
+#define N_ITERATIONS 10
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static ddaf_context_t* create(ddaf_type_t type) {
+    ddaf_context_t* ctx = ddaf_create_context(type, DDAF_ARCH_CNN, 0);
+    if (!ctx) return NULL;
+    
+    int ret = -1;
+    switch (type) {
+        case DDAF_TYPE_DATA_DRIVEN:
+            ret = ddaf_init_data_driven(ctx, N_PARAMS);
+            break;
+        case DDAF_TYPE_DYNAMIC:
+            ret = ddaf_init_dynamic(ctx, N_PARAMS);
+            break;
+        case DDAF_TYPE_ONLINE:
+            ret = ddaf_init_online(ctx, N_PARAMS);
+            break;
+        default:
+            break;
+    }
+    if (ret != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+int main() {
+    size_t size = N_ELEMENTS;
+    const char* names[] = { "data-driven", "dynamic", "online" };
+    ddaf_type_t types[] = { DDAF_TYPE_DATA_DRIVEN, DDAF_TYPE_DYNAMIC,
+                            DDAF_TYPE_ONLINE };
+    
+    /* Streamed passes over the tensor: statistics sweeps plus the store */
+    int passes[] = { 3, 2, 3 };
+    
+    float* input = (float*)malloc(size * sizeof(float));
+    float* output = (float*)malloc(size * sizeof(float));
+    uint16_t* input16 = (uint16_t*)malloc(size * sizeof(uint16_t));
+    uint16_t* output16 = (uint16_t*)malloc(size * sizeof(uint16_t));
+    float* widened = (float*)malloc(size * sizeof(float));
+    if (!input || !output || !input16 || !output16 || !widened) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(output);
+        free(input16);
+        free(output16);
+        free(widened);
+        return 1;
+    }
+    
+    srand(13);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 4.0f - 2.0f;
+    }
+    
+    printf("%zu elements, ISA %d\n\n", size, (int)ddaf_get_isa());
+    printf("%12s %6s %10s %10s %10s %8s %11s\n", "type", "dtype", "ms",
+           "GB/s", "B/elem", "speedup", "max error");
+    
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        double float_ms = 0.0;
+        
+        for (int dtype = -1; dtype < DDAF_DTYPE_COUNT; dtype++) {
+            ddaf_context_t* ctx = create(types[t]);
+            ddaf_context_t* ref = create(types[t]);
+            if (!ctx || !ref) {
+                fprintf(stderr, "Failed to create %s context\n", names[t]);
+                ddaf_destroy_context(ctx);
+                ddaf_destroy_context(ref);
+                continue;
+            }
+            
+            /* The reference runs in float on the same (rounded) input */
+            if (dtype >= 0) {
+                ddaf_narrow((ddaf_dtype_t)dtype, input, input16, size);
+                ddaf_widen((ddaf_dtype_t)dtype, input16, widened, size);
+            }
+            
+            double start = now_seconds();
+            for (int it = 0; it < N_ITERATIONS; it++) {
+                if (dtype == DDAF_DTYPE_F16) {
+                    ddaf_forward_f16(ctx, input16, output16, size);
+                } else if (dtype == DDAF_DTYPE_BF16) {
+                    ddaf_forward_bf16(ctx, input16, output16, size);
+                } else {
+                    ddaf_forward(ctx, input, output, size);
+                }
+            }
+            double ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+            
+            double max_error = 0.0;
+            if (dtype >= 0) {
+                for (int it = 0; it < N_ITERATIONS; it++) {
+                    ddaf_forward(ref, widened, output, size);
+                }
+                ddaf_widen((ddaf_dtype_t)dtype, output16, widened, size);
+                for (size_t i = 0; i < size; i++) {
+                    double error = fabs((double)widened[i] - output[i]) /
+                                   (fabs(output[i]) + 1e-3);
+                    if (error > max_error) max_error = error;
+                }
+            } else {
+                float_ms = ms;
+            }
+            
+            size_t element = dtype >= 0 ? sizeof(uint16_t) : sizeof(float);
+            double bytes = (double)passes[t] * element * size;
+            printf("%12s %6s %10.3f %10.2f %10zu %8.2f %11.2e\n", names[t],
+                   dtype == DDAF_DTYPE_F16 ? "f16" :
+                   dtype == DDAF_DTYPE_BF16 ? "bf16" : "f32",
+                   ms, bytes / (ms * 1e6), passes[t] * element,
+                   float_ms / ms, max_error);
+            
+            ddaf_destroy_context(ctx);
+            ddaf_destroy_context(ref);
+        }
+    }
+    
+    free(input);
+    free(output);
+    free(input16);
+    free(output16);
+    free(widened);
+    
+    return 0;
+}
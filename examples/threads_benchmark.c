@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Thread scaling of the elementwise types on a 512 x 2048 transformer
+ * activation, of dense attention over (head, query block) tiles and of
+ * mixture of experts with concurrent experts, with a check that every thread count
+ * gives the single-thread output bit for bit
+ */
+
+#include "ddaf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define D_MODEL 512
+#define SEQ_LEN 2048
+#define N_PARAMS 1024
+#define N_ITERATIONS 10
+#define N_HEADS 8
+#define N_EXPERTS 16
+#define K_EXPERTS 2
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static ddaf_context_t* create(ddaf_type_t type) {
+    ddaf_context_t* ctx = ddaf_create_context(type, DDAF_ARCH_CNN, 0);
+    if (!ctx) return NULL;
+    
+    int ret = -1;
+    switch (type) {
+        case DDAF_TYPE_DATA_DRIVEN:
+            ret = ddaf_init_data_driven(ctx, N_PARAMS);
+            break;
+        case DDAF_TYPE_DYNAMIC:
+            ret = ddaf_init_dynamic(ctx, N_PARAMS);
+            break;
+        case DDAF_TYPE_ONLINE:
+            ret = ddaf_init_online(ctx, N_PARAMS);
+            break;
+        default:
+            break;
+    }
+    if (ret != 0 || ddaf_set_save_policy(ctx, DDAF_SAVE_INPUT) != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/* Dense: the summary mode evaluates no scores and has no tiles */
+static ddaf_context_t* create_attention(size_t seq_len) {
+    ddaf_context_t* ctx = ddaf_create_context(DDAF_TYPE_ATTENTION,
+                                              DDAF_ARCH_TRANSFORMER, 0);
+    if (!ctx) return NULL;
+    
+    if (ddaf_transformer_init(ctx, D_MODEL, N_HEADS, seq_len) != 0 ||
+        ddaf_set_attention_mode(ctx, DDAF_ATTENTION_DENSE) != 0 ||
+        ddaf_set_save_policy(ctx, DDAF_SAVE_INPUT) != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+static ddaf_context_t* create_moe(void) {
+    ddaf_context_t* ctx = ddaf_create_context(DDAF_TYPE_DATA_DRIVEN,
+                                              DDAF_ARCH_MOE, 0);
+    if (!ctx) return NULL;
+    
+    if (ddaf_moe_init(ctx, D_MODEL, N_EXPERTS, K_EXPERTS) != 0) {
+        ddaf_destroy_context(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+int main() {
+    size_t size = (size_t)D_MODEL * SEQ_LEN;
+    const char* names[] = { "data-driven", "dynamic", "online" };
+    ddaf_type_t types[] = { DDAF_TYPE_DATA_DRIVEN, DDAF_TYPE_DYNAMIC,
+                            DDAF_TYPE_ONLINE };
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cpus > 4 ? (size_t)cpus : 4;
+    
+    float* input = (float*)malloc(size * sizeof(float));
+    float* output = (float*)malloc(size * sizeof(float));
+    float* grad = (float*)malloc(size * sizeof(float));
+    float* reference = (float*)malloc(size * sizeof(float));
+    if (!input || !output || !grad || !reference) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(input);
+        free(output);
+        free(grad);
+        free(reference);
+        return 1;
+    }
+    
+    srand(17);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = ((float)rand() / RAND_MAX) * 4.0f - 2.0f;
+    }
+    
+    printf("%d x %d activation, %ld online CPUs\n\n", D_MODEL, SEQ_LEN, cpus);
+    printf("%12s %8s %10s %10s %10s %10s %10s\n", "type", "threads", "fwd ms",
+           "bwd ms", "speedup", "efficiency", "identical");
+    
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        double single_ms = 0.0;
+        
+        for (size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+            if (ddaf_set_num_threads(n_threads) != 0) {
+                fprintf(stderr, "Failed to start %zu threads\n", n_threads);
+                break;
+            }
+            
+            /* Same call sequence on a fresh context for every thread count */
+            ddaf_context_t* ctx = create(types[t]);
+            if (!ctx) {
+                fprintf(stderr, "Failed to create %s context\n", names[t]);
+                break;
+            }
+            
+            double start = now_seconds();
+            for (int it = 0; it < N_ITERATIONS; it++) {
+                ddaf_forward(ctx, input, output, size);
+            }
+            double forward_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+            
+            start = now_seconds();
+            for (int it = 0; it < N_ITERATIONS; it++) {
+                ddaf_backward(ctx, output, grad, size);
+            }
+            double backward_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+            
+            bool identical = true;
+            if (n_threads == 1) {
+                single_ms = forward_ms + backward_ms;
+                memcpy(reference, grad, size * sizeof(float));
+            } else {
+                identical = memcmp(reference, grad, size * sizeof(float)) == 0;
+            }
+            
+            double speedup = single_ms / (forward_ms + backward_ms);
+            printf("%12s %8zu %10.3f %10.3f %10.2f %9.0f%% %10s\n", names[t],
+                   n_threads, forward_ms, backward_ms, speedup,
+                   100.0 * speedup / n_threads, identical ? "yes" : "NO");
+            
+            ddaf_destroy_context(ctx);
+        }
+    }
+    
+    /*
+     * Attention: d_model 512, 8 heads, growing sequence length. The dense
+     * weight matrix at SEQ_LEN would be 128 MB, so it stops at 512.
+     */
+    size_t seq_lens[] = { 128, 256, 512 };
+    
+    printf("\nDense attention, %d heads\n\n", N_HEADS);
+    printf("%8s %8s %10s %10s %10s %10s\n", "seq_len", "threads", "fwd ms",
+           "speedup", "efficiency", "identical");
+    
+    for (size_t s = 0; s < sizeof(seq_lens) / sizeof(seq_lens[0]); s++) {
+        size_t count = (size_t)D_MODEL * seq_lens[s];
+        double single_ms = 0.0;
+        
+        for (size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+            if (ddaf_set_num_threads(n_threads) != 0) {
+                fprintf(stderr, "Failed to start %zu threads\n", n_threads);
+                break;
+            }
+            
+            ddaf_context_t* ctx = create_attention(seq_lens[s]);
+            if (!ctx) {
+                fprintf(stderr, "Failed to create attention context\n");
+                break;
+            }
+            
+            double start = now_seconds();
+            for (int it = 0; it < N_ITERATIONS; it++) {
+                ddaf_forward(ctx, input, output, count);
+            }
+            double forward_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+            
+            bool identical = true;
+            if (n_threads == 1) {
+                single_ms = forward_ms;
+                memcpy(reference, output, count * sizeof(float));
+            } else {
+                identical = memcmp(reference, output,
+                                   count * sizeof(float)) == 0;
+            }
+            
+            double speedup = single_ms / forward_ms;
+            printf("%8zu %8zu %10.3f %10.2f %9.0f%% %10s\n", seq_lens[s],
+                   n_threads, forward_ms, speedup,
+                   100.0 * speedup / n_threads, identical ? "yes" : "NO");
+            
+            ddaf_destroy_context(ctx);
+        }
+    }
+    
+    /* MoE: one batch of SEQ_LEN tokens, each expert a task */
+    printf("\nMoE, %d experts, top %d, %d tokens\n\n", N_EXPERTS, K_EXPERTS,
+           SEQ_LEN);
+    printf("%8s %10s %10s %10s %10s\n", "threads", "fwd ms", "speedup",
+           "efficiency", "identical");
+    
+    double moe_single_ms = 0.0;
+    for (size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+        if (ddaf_set_num_threads(n_threads) != 0) {
+            fprintf(stderr, "Failed to start %zu threads\n", n_threads);
+            break;
+        }
+        
+        ddaf_context_t* ctx = create_moe();
+        if (!ctx) {
+            fprintf(stderr, "Failed to create MoE context\n");
+            break;
+        }
+        
+        double start = now_seconds();
+        for (int it = 0; it < N_ITERATIONS; it++) {
+            ddaf_moe_forward_batch(ctx, input, output, SEQ_LEN);
+        }
+        double forward_ms = (now_seconds() - start) / N_ITERATIONS * 1e3;
+        
+        bool identical = true;
+        if (n_threads == 1) {
+            moe_single_ms = forward_ms;
+            memcpy(reference, output, size * sizeof(float));
+        } else {
+            identical = memcmp(reference, output, size * sizeof(float)) == 0;
+        }
+        
+        double speedup = moe_single_ms / forward_ms;
+        printf("%8zu %10.3f %10.2f %9.0f%% %10s\n", n_threads, forward_ms,
+               speedup, 100.0 * speedup / n_threads, identical ? "yes" : "NO");
+        
+        ddaf_destroy_context(ctx);
+    }
+    
+    ddaf_set_num_threads(1);
+    
+    free(input);
+    free(output);
+    free(grad);
+    free(reference);
+    
+    return 0;
+}
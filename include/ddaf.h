@@ -20,6 +20,9 @@ extern "C" {
 typedef struct ddaf_context ddaf_context_t;
 typedef struct ddaf_activation ddaf_activation_t;
 typedef struct ddaf_memory_pool ddaf_memory_pool_t;
+typedef struct ddaf_pool_slab ddaf_pool_slab_t;
+typedef struct ddaf_relocation ddaf_relocation_t;
+typedef struct ddaf_session ddaf_session_t;
 
 /* Activation function types */
 typedef enum {
@@ -41,6 +44,65 @@ typedef enum {
     DDAF_ARCH_MOE
 } ddaf_arch_t;
 
+/*
+ * Accuracy tiers for the transcendental kernels. Measured maximum absolute
+ * error against a double-precision reference over [-10, 10]
+ * (GELU / Swish / sigmoid / tanh):
+ *   EXACT    5.2e-7 / 1.2e-6 / 8.9e-8 / 1.0e-7   libm-equivalent
+ *   FAST     1.0e-5 / 1.7e-5 / 1.9e-5 / 3.8e-5   degree-3 minimax exp
+ *   FASTEST  2.4e-3 / 2.0e-3 / 6.0e-4 / 1.2e-3   degree-2 exp, raw rcp
+ * examples/precision_benchmark.c reports error against throughput.
+ */
+typedef enum {
+    DDAF_PRECISION_EXACT = 0,
+    DDAF_PRECISION_FAST,
+    DDAF_PRECISION_FASTEST
+} ddaf_precision_t;
+
+/* Interpolation used by baked lookup-table activations */
+typedef enum {
+    DDAF_INTERP_LINEAR = 0,
+    DDAF_INTERP_CUBIC
+} ddaf_interp_t;
+
+/* SIMD instruction set used by the array kernels */
+typedef enum {
+    DDAF_ISA_SCALAR = 0,
+    DDAF_ISA_SSE42,
+    DDAF_ISA_AVX2,
+    DDAF_ISA_AVX512
+} ddaf_isa_t;
+
+/*
+ * Softmax evaluation for attention activations. Each softmax row sums to 1,
+ * so SUMMARY writes the per-position summary directly and keeps only those
+ * seq_len floats; DENSE builds Q, K, V and the n_heads x seq_len x seq_len
+ * weight matrix and is kept for validation.
+ */
+typedef enum {
+    DDAF_ATTENTION_SUMMARY = 0,
+    DDAF_ATTENTION_DENSE
+} ddaf_attention_mode_t;
+
+/*
+ * Memory callbacks. Members left NULL fall back to libc; without a
+ * realloc_fn, reallocation is free followed by malloc.
+ */
+typedef struct {
+    void* (*malloc_fn)(size_t size, void* user_data);
+    void* (*realloc_fn)(void* ptr, size_t size, void* user_data);
+    void (*free_fn)(void* ptr, void* user_data);
+    void* user_data;
+} ddaf_allocator_t;
+
+/* Creation options, inherited by nested contexts */
+typedef struct {
+    size_t pool_size;           /* Initial pool bytes, 0 to start empty */
+    size_t alignment;           /* Pool alignment, 0 for DDAF_POOL_ALIGNMENT */
+    unsigned pool_flags;        /* ddaf_pool_flags_t */
+    ddaf_allocator_t allocator; /* Params, pools and the context itself */
+} ddaf_context_options_t;
+
 /* Activation function pointer */
 typedef float (*ddaf_activation_fn)(float x, void* params);
 
@@ -52,6 +114,58 @@ typedef int (*ddaf_forward_fn)(ddaf_context_t* ctx, const float* input,
 typedef int (*ddaf_backward_fn)(ddaf_context_t* ctx, const float* grad_output,
                                 float* grad_input, size_t size);
 
+/* 16-bit storage formats: IEEE binary16 and bfloat16 */
+typedef enum {
+    DDAF_DTYPE_F16 = 0,
+    DDAF_DTYPE_BF16
+} ddaf_dtype_t;
+
+/* Forward pass over 16-bit storage, computing in float */
+typedef int (*ddaf_forward16_fn)(ddaf_context_t* ctx, const uint16_t* input,
+                                 uint16_t* output, size_t size,
+                                 ddaf_dtype_t dtype);
+
+/* Pool bytes a forward or backward call on size elements needs */
+typedef size_t (*ddaf_workspace_fn)(const ddaf_context_t* ctx, size_t size);
+
+/*
+ * What a context keeps of its forward input for the backward pass. With
+ * nothing kept, backward falls back to an input-free approximation.
+ */
+typedef enum {
+    DDAF_SAVE_NONE = 0,
+    DDAF_SAVE_INPUT,        /* Float copy */
+    DDAF_SAVE_FP16,         /* Half-precision copy, half the memory */
+    DDAF_SAVE_RECOMPUTE,    /* Rebuilt from the parent's saved input */
+    DDAF_SAVE_AUTO          /* Chosen per call against the tree's budget */
+} ddaf_save_policy_t;
+
+/* Rebuild the forward input of a nested context into input */
+typedef int (*ddaf_recompute_fn)(ddaf_context_t* ctx,
+                                 const ddaf_context_t* child,
+                                 float* input, size_t size);
+
+/* Statistics of a batched call */
+typedef enum {
+    DDAF_BATCH_SHARED = 0,          /* One set over the whole batch */
+    DDAF_BATCH_PER_SAMPLE = 1 << 0  /* One set per sample */
+} ddaf_batch_flags_t;
+
+/* Forward or backward pass over batch samples of sample_size floats */
+typedef int (*ddaf_batched_fn)(ddaf_context_t* ctx, const float* input,
+                               float* output, size_t batch,
+                               size_t sample_size, unsigned flags);
+
+/* Re-point the internal pointers of moved params (ddaf_compact) */
+typedef void (*ddaf_relocate_fn)(ddaf_context_t* ctx,
+                                 const ddaf_relocation_t* reloc);
+
+/*
+ * Leading bytes of the params block that calls may write. A session copies
+ * them and shares the rest of the block with its model.
+ */
+typedef size_t (*ddaf_state_size_fn)(const ddaf_context_t* ctx);
+
 /* Context structure */
 struct ddaf_context {
     ddaf_type_t type;
@@ -59,35 +173,237 @@ struct ddaf_context {
     void* params;
     ddaf_forward_fn forward;
     ddaf_backward_fn backward;
-    ddaf_memory_pool_t* pool;
+    ddaf_memory_pool_t* pool;     /* Shared with the parent when nested */
+    bool owns_pool;
     bool requires_grad;
+    ddaf_precision_t precision;
+    ddaf_context_t* parent;       /* Owning architecture context, if nested */
+    ddaf_context_t* first_child;  /* Nested contexts created by *_init */
+    ddaf_context_t* next_sibling;
+    void* baked;                  /* Frozen lookup tables (ddaf_bake) */
+    ddaf_context_options_t options;
+    ddaf_relocate_fn relocate;
+    ddaf_workspace_fn forward_workspace;  /* NULL: no pool scratch */
+    ddaf_workspace_fn backward_workspace;
+    size_t params_size;           /* Bytes of the params block */
+    size_t baked_size;            /* Bytes of the baked block */
+    void* arena;                  /* Root only: block from ddaf_compact */
+    size_t arena_size;
+    ddaf_recompute_fn recompute;
+    ddaf_save_policy_t save_policy;
+    ddaf_save_policy_t saved_as;  /* What the last forward actually kept */
+    void* saved;                  /* Forward input kept for backward */
+    size_t saved_count;           /* Elements of the last forward */
+    size_t saved_capacity;        /* Bytes allocated for saved */
+    size_t memory_budget;         /* Root only: bytes for DDAF_SAVE_AUTO */
+    size_t memory_used;           /* Root only: bytes saved this step */
+    bool replay;                  /* Recompute pass: no state updates */
+    ddaf_forward16_fn forward16;  /* NULL: widened through pool scratch */
+    ddaf_batched_fn forward_batched;  /* NULL: one sample at a time */
+    ddaf_batched_fn backward_batched; /* NULL: no batched backward */
+    size_t batch;                 /* Samples of the current call, 1 unbatched */
+    unsigned batch_flags;         /* Its ddaf_batch_flags_t */
+    float* batch_state;           /* Recurrent state of each sample */
+    size_t batch_state_size;      /* Floats in batch_state */
+    ddaf_state_size_fn state_size;    /* NULL: sessions copy all params */
 };
 
-/* Memory pool structure */
+/* Default pool alignment: one cache line, the widest SIMD load */
+#define DDAF_POOL_ALIGNMENT 64
+
+/* Pool creation flags */
+typedef enum {
+    DDAF_POOL_HUGE_PAGES = 1 << 0   /* mmap slabs with MADV_HUGEPAGE */
+} ddaf_pool_flags_t;
+
+/*
+ * Memory pool structure. A chunked bump arena: when the current slab is
+ * full a larger one is linked after it. Offsets (used, marks) are global
+ * across slabs.
+ */
 struct ddaf_memory_pool {
-    void* buffer;
-    size_t size;
+    void* buffer;               /* First slab */
+    size_t size;                /* Capacity across all slabs */
     size_t used;
     bool owns_buffer;
+    size_t alignment;
+    size_t high_water;          /* Peak of used since creation */
+    unsigned flags;             /* ddaf_pool_flags_t */
+    ddaf_allocator_t allocator;
+    ddaf_pool_slab_t* slabs;
+    ddaf_pool_slab_t* current;  /* Slab holding the top of the stack */
 };
 
 /* Core API */
 ddaf_context_t* ddaf_create_context(ddaf_type_t type, ddaf_arch_t arch, 
                                      size_t param_size);
+ddaf_context_t* ddaf_create_context_ex(ddaf_type_t type, ddaf_arch_t arch,
+                                       size_t param_size,
+                                       const ddaf_context_options_t* options);
+void ddaf_context_options_init(ddaf_context_options_t* options);
 void ddaf_destroy_context(ddaf_context_t* ctx);
 
+/* Accuracy tier, applied to ctx and every nested context */
+int ddaf_set_precision(ddaf_context_t* ctx, ddaf_precision_t precision);
+ddaf_precision_t ddaf_get_precision(const ddaf_context_t* ctx);
+
+/*
+ * Freeze the current parameters of ctx (and every nested context) into
+ * lookup tables over [x_min, x_max] with n_segments intervals. Forward
+ * passes then interpolate instead of evaluating exp/tanh, and the dynamic
+ * type stops updating its parameters. Inputs below x_min clamp to the
+ * table edge and inputs above x_max follow the linear asymptote, so the
+ * range should reach the tails (e.g. [-16, 16]).
+ */
+int ddaf_bake(ddaf_context_t* ctx, float x_min, float x_max,
+              size_t n_segments, ddaf_interp_t interp);
+void ddaf_unbake(ddaf_context_t* ctx);
+
+/*
+ * Move the params, baked tables and nested context structs of a root
+ * context into one aligned block, laid out depth first (each context's
+ * struct, params and tables, then its children). The root struct stays in
+ * place, and the block is freed with the root. Contexts re-initialized
+ * afterwards allocate separately again; compact once more to regroup.
+ * Returns -1 for a nested context or when the block cannot be allocated.
+ */
+int ddaf_compact(ddaf_context_t* ctx);
+
+/*
+ * Saved inputs for backward (activation checkpointing), applied to ctx and
+ * every nested context. DDAF_SAVE_RECOMPUTE replays the forward path from
+ * the nearest ancestor that kept its input. Contexts whose input cannot be
+ * rebuilt (inside RNN, LSTM and GRU) fall back to the approximation.
+ *
+ * ddaf_set_memory_budget sets DDAF_SAVE_AUTO on the tree of a root context.
+ * During each forward, every context picks, in call order, the first
+ * option that works: recompute from a parent that kept a checkpoint, a
+ * float copy if it fits the remaining budget, then a half-precision copy.
+ * Contexts that fit nothing use the approximation. ddaf_saved_bytes reports
+ * the bytes the last forward kept across the tree.
+ */
+int ddaf_set_save_policy(ddaf_context_t* ctx, ddaf_save_policy_t policy);
+int ddaf_set_memory_budget(ddaf_context_t* ctx, size_t bytes);
+size_t ddaf_saved_bytes(const ddaf_context_t* ctx);
+
 /* Memory management */
 ddaf_memory_pool_t* ddaf_create_pool(size_t size);
+ddaf_memory_pool_t* ddaf_create_pool_ex(size_t size, size_t alignment,
+                                        unsigned flags,
+                                        const ddaf_allocator_t* allocator);
 void ddaf_destroy_pool(ddaf_memory_pool_t* pool);
 void* ddaf_pool_alloc(ddaf_memory_pool_t* pool, size_t size);
 void ddaf_pool_reset(ddaf_memory_pool_t* pool);
 
-/* Activation functions */
+/*
+ * Stack-like frames: everything allocated after ddaf_pool_mark() is freed
+ * by ddaf_pool_release() with that mark. ddaf_forward and ddaf_backward
+ * wrap every call in such a frame, so per-call scratch is reused.
+ */
+size_t ddaf_pool_mark(const ddaf_memory_pool_t* pool);
+void ddaf_pool_release(ddaf_memory_pool_t* pool, size_t mark);
+
+/* Largest offset reached; a pool created with this size never grows */
+size_t ddaf_pool_high_water(const ddaf_memory_pool_t* pool);
+
+/*
+ * Activation functions. Every type and architecture supports in-place
+ * calls: input may equal output, and grad_output may equal grad_input.
+ * Partially overlapping arrays are not supported.
+ */
 int ddaf_forward(ddaf_context_t* ctx, const float* input, float* output, 
                  size_t size);
 int ddaf_backward(ddaf_context_t* ctx, const float* grad_output, 
                   float* grad_input, size_t size);
 
+/*
+ * 16-bit variants: tensors are stored as fp16 or bf16 (raw bits) and
+ * widened to float in cache-sized blocks, with statistics accumulated in
+ * float or wider. The data-driven, dynamic and online types read and write
+ * 16-bit data directly. Other types, architectures and all backward passes
+ * widen the whole tensor in pool scratch and narrow the result.
+ */
+int ddaf_forward_f16(ddaf_context_t* ctx, const uint16_t* input,
+                     uint16_t* output, size_t size);
+int ddaf_forward_bf16(ddaf_context_t* ctx, const uint16_t* input,
+                      uint16_t* output, size_t size);
+int ddaf_backward_f16(ddaf_context_t* ctx, const uint16_t* grad_output,
+                      uint16_t* grad_input, size_t size);
+int ddaf_backward_bf16(ddaf_context_t* ctx, const uint16_t* grad_output,
+                       uint16_t* grad_input, size_t size);
+
+/*
+ * Batched passes over batch samples of sample_size floats, stored one after
+ * another. Per-position parameters index each sample from its start, and
+ * the call runs in one pool frame with one saved input for the batch.
+ * flags picks the statistics (ddaf_batch_flags_t):
+ *   DDAF_BATCH_SHARED      data-driven statistics span the whole batch, and
+ *                          online statistics take it as one stream
+ *   DDAF_BATCH_PER_SAMPLE  each sample is normalized by its own statistics,
+ *                          updated in sample order, as a loop over
+ *                          ddaf_forward would
+ * The dynamic type updates each position once per sample in sample order
+ * either way. RNN, LSTM and GRU keep one recurrent state per sample; a
+ * call with a new batch size starts every sample from the unbatched state.
+ * A replayed batch (DDAF_SAVE_RECOMPUTE) sees the dynamic parameters and
+ * online windows as the whole batch left them. Contexts without a batched
+ * path (mixture of experts) run the samples one by one, and their batched
+ * backward returns -1.
+ */
+int ddaf_forward_batched(ddaf_context_t* ctx, const float* input,
+                         float* output, size_t batch, size_t sample_size,
+                         unsigned flags);
+int ddaf_backward_batched(ddaf_context_t* ctx, const float* grad_output,
+                          float* grad_input, size_t batch, size_t sample_size,
+                          unsigned flags);
+
+/*
+ * Sessions: per-thread state over a shared, read-only model. A session
+ * mirrors the model's context tree with its own pool, saved inputs and
+ * copy of everything calls write: statistics, online windows, recurrent
+ * state, attention scratch, and dynamic parameters unless baked. Baked
+ * tables, data-driven adaptive weights and baked dynamic parameters stay
+ * with the model, so any number of sessions share one copy. A session
+ * starts from the model's state when created or reset.
+ *
+ * Each session serves one thread at a time; different sessions may run
+ * at once. The model must not be re-initialized, baked, compacted or
+ * destroyed while it has sessions. Calls on the model itself come from one
+ * thread, and not while a session is created or reset.
+ * With the thread pool started, one call at a time uses the workers and
+ * the others run inline.
+ */
+ddaf_session_t* ddaf_create_session(const ddaf_context_t* model);
+void ddaf_destroy_session(ddaf_session_t* session);
+void ddaf_reset_session(ddaf_session_t* session);
+int ddaf_session_forward(ddaf_session_t* session, const float* input,
+                         float* output, size_t size);
+int ddaf_session_backward(ddaf_session_t* session, const float* grad_output,
+                          float* grad_input, size_t size);
+int ddaf_session_forward_batched(ddaf_session_t* session, const float* input,
+                                 float* output, size_t batch,
+                                 size_t sample_size, unsigned flags);
+int ddaf_session_backward_batched(ddaf_session_t* session,
+                                  const float* grad_output, float* grad_input,
+                                  size_t batch, size_t sample_size,
+                                  unsigned flags);
+
+/*
+ * Caller-provided scratch. The *_workspace_size queries return the bytes a
+ * float call on size elements takes from the pool, with slack for an
+ * unaligned workspace. That is 0 for the core types unless a saved input
+ * has to be decoded or recomputed. The *_ws variants serve all of the
+ * call's scratch, nested contexts included, from workspace and never
+ * allocate; they return -1 if workspace_size is too small.
+ */
+size_t ddaf_forward_workspace_size(const ddaf_context_t* ctx, size_t size);
+size_t ddaf_backward_workspace_size(const ddaf_context_t* ctx, size_t size);
+int ddaf_forward_ws(ddaf_context_t* ctx, const float* input, float* output,
+                    size_t size, void* workspace, size_t workspace_size);
+int ddaf_backward_ws(ddaf_context_t* ctx, const float* grad_output,
+                     float* grad_input, size_t size, void* workspace,
+                     size_t workspace_size);
+
 /* Core activation type initialization */
 int ddaf_init_data_driven(ddaf_context_t* ctx, size_t stat_size);
 int ddaf_init_dynamic(ddaf_context_t* ctx, size_t param_count);
@@ -95,6 +411,9 @@ int ddaf_init_online(ddaf_context_t* ctx, size_t buffer_size);
 int ddaf_init_attention(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
                         size_t seq_len);
 
+/* Applied to ctx and every nested attention context (default TILED) */
+int ddaf_set_attention_mode(ddaf_context_t* ctx, ddaf_attention_mode_t mode);
+
 /* Architecture-specific APIs */
 int ddaf_cnn_init(ddaf_context_t* ctx, size_t channels, size_t height, 
                   size_t width);
@@ -110,6 +429,40 @@ int ddaf_bigbird_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
 int ddaf_moe_init(ddaf_context_t* ctx, size_t d_model, size_t n_experts,
                   size_t k_experts);
 
+/*
+ * Route n_tokens rows of d_model floats at once. Tokens are grouped into
+ * per-expert buckets in token order, each expert runs once over its bucket
+ * with every token a sample of its own (as DDAF_BATCH_PER_SAMPLE), and the
+ * results are scattered back scaled by the router weights. Without a
+ * capacity limit this gives ddaf_forward on each token in turn, up to the
+ * order in which more than two experts' outputs are summed. An expert
+ * accepts at most ceil(capacity_factor * n_tokens * k_experts / n_experts)
+ * tokens; overflow assignments are dropped (first choices claim capacity
+ * before second choices). A capacity factor <= 0 (the default) disables
+ * the limit. input and output must not overlap.
+ */
+int ddaf_moe_forward_batch(ddaf_context_t* ctx, const float* input,
+                           float* output, size_t n_tokens);
+int ddaf_moe_set_capacity_factor(ddaf_context_t* ctx, float capacity_factor);
+
+/* Vectorized array kernels (dispatched on CPU features at startup) */
+void ddaf_gelu_f32(const float* input, float* output, size_t n);
+void ddaf_swish_f32(const float* input, float* output, size_t n);
+void ddaf_sigmoid_f32(const float* input, float* output, size_t n);
+void ddaf_tanh_f32(const float* input, float* output, size_t n);
+ddaf_isa_t ddaf_get_isa(void);
+int ddaf_set_isa(ddaf_isa_t isa); /* -1 if the CPU lacks the ISA */
+
+/*
+ * Threads shared by all contexts for large elementwise calls (0: one per
+ * online CPU; default 1, no pool). Calls longer than one chunk are split
+ * into cache-sized chunks; statistics fold per-chunk partials in a fixed
+ * order, so results do not depend on the thread count. Not to be called
+ * while another thread is inside a forward or backward call.
+ */
+int ddaf_set_num_threads(size_t n_threads);
+size_t ddaf_get_num_threads(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,24 @@
 #define DDAF_MAX(a, b) ((a) > (b) ? (a) : (b))
 #define DDAF_MIN(a, b) ((a) < (b) ? (a) : (b))
 
+/* Elements processed per stack block by the fused forward loops */
+#define DDAF_KERNEL_BLOCK 256
+
+/* Elements per L1-resident block of the mean/variance reduction */
+#define DDAF_STATS_BLOCK 2048
+
+/* Samples per closed-form step of the online exponential moving average */
+#define DDAF_EMA_BLOCK 8
+
+/* Elements per chunk of a pooled call; calls of one chunk run inline */
+#define DDAF_PARALLEL_GRAIN 16384
+
+/* Chunk partials a statistics reduction folds per round (stack bound) */
+#define DDAF_PARALLEL_ROUND 256
+
+/* Upper bound of ddaf_set_num_threads */
+#define DDAF_MAX_THREADS 256
+
 /* Data-driven activation parameters */
 typedef struct {
     float* statistics;      /* Running statistics */
@@ -41,20 +59,28 @@ typedef struct {
     size_t buffer_size;
     size_t buffer_idx;
     float forgetting_factor;
+    double window_sum;      /* Running sum of buffer */
+    double window_sumsq;    /* Running sum of squares of buffer */
+    size_t since_rebase;    /* Updates since the sums were recomputed */
 } ddaf_online_params_t;
 
 /* Attention activation parameters */
 typedef struct {
-    float* query;           /* Query vectors */
-    float* key;             /* Key vectors */
-    float* value;            /* Value vectors */
-    float* attention_weights; /* Attention weights */
+    float* query;           /* Query vectors (dense mode only) */
+    float* key;             /* Key vectors (dense mode only) */
+    float* value;           /* Value vectors (dense mode only) */
+    float* attention_weights; /* Attention weights (dense mode only) */
+    float* row_summary;     /* Per-position attention mean, kept for backward */
     size_t d_model;
     size_t n_heads;
     size_t seq_len;
     float temperature;
+    ddaf_attention_mode_t mode;
 } ddaf_attention_params_t;
 
+/* Query rows per tile of the dense softmax */
+#define DDAF_ATTENTION_BLOCK_Q 32
+
 /* Helper functions */
 static inline float ddaf_sigmoid(float x) {
     return 1.0f / (1.0f + expf(-x));
@@ -76,4 +102,367 @@ static inline float ddaf_swish(float x) {
     return x * ddaf_sigmoid(x);
 }
 
+/* Derivatives of the scalar curves above */
+static inline float ddaf_gelu_grad(float x) {
+    const float c = sqrtf(2.0f / M_PI);
+    float t = tanhf(c * (x + 0.044715f * x * x * x));
+    return 0.5f * (1.0f + t) +
+           0.5f * x * (1.0f - t * t) * c * (1.0f + 3.0f * 0.044715f * x * x);
+}
+
+static inline float ddaf_swish_grad(float x) {
+    float s = ddaf_sigmoid(x);
+    return s + x * s * (1.0f - s);
+}
+
+/* IEEE binary16 conversion, round to nearest even */
+static inline uint16_t ddaf_float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t abs = bits & 0x7fffffffu;
+    
+    if (abs > 0x7f800000u) {            /* NaN: quiet, top payload bits */
+        return (uint16_t)(sign | 0x7e00u | ((abs >> 13) & 0x3ffu));
+    }
+    if (abs >= 0x477ff000u) {           /* Inf, or rounds past 65504 */
+        return (uint16_t)(sign | 0x7c00u);
+    }
+    if (abs < 0x38800000u) {            /* Subnormal half or zero */
+        if (abs < 0x33000000u) return (uint16_t)sign;
+        uint32_t mant = (abs & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 126u - (abs >> 23);
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1u);
+        if (rem > halfway || (rem == halfway && (half & 1u))) half++;
+        return (uint16_t)(sign | half);
+    }
+    
+    uint32_t half = (abs - 0x38000000u) >> 13;
+    uint32_t rem = abs & 0x1fffu;
+    if (rem > 0x1000u || (rem == 0x1000u && (half & 1u))) half++;
+    return (uint16_t)(sign | half);
+}
+
+static inline float ddaf_half_to_float(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1fu;
+    uint32_t mant = half & 0x3ffu;
+    uint32_t bits;
+    
+    if (exponent == 0x1fu) {
+        bits = sign | 0x7f800000u | (mant << 13);
+    } else if (exponent == 0) {
+        float value = (float)mant * 5.9604644775390625e-8f; /* 2^-24 */
+        memcpy(&bits, &value, sizeof(bits));
+        bits |= sign;
+    } else {
+        bits = sign | ((exponent + 112u) << 23) | (mant << 13);
+    }
+    
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* bfloat16: the high half of a float, round to nearest even */
+static inline uint16_t ddaf_float_to_bf16(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7fffffffu) > 0x7f800000u) {
+        return (uint16_t)((bits >> 16) | 0x40u);
+    }
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return (uint16_t)(bits >> 16);
+}
+
+static inline float ddaf_bf16_to_float(uint16_t value) {
+    uint32_t bits = (uint32_t)value << 16;
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/* Count, mean and sum of squared deviations of a block (Chan et al.) */
+typedef struct {
+    double count;
+    double mean;
+    double m2;
+} ddaf_moments_t;
+
+void ddaf_moments_block(const float* x, size_t n, ddaf_moments_t* out);
+void ddaf_moments_merge(ddaf_moments_t* acc, const ddaf_moments_t* other);
+void ddaf_moments_compute(const float* x, size_t n, ddaf_moments_t* out);
+void ddaf_moments_compute16(const uint16_t* x, size_t n, ddaf_dtype_t dtype,
+                            ddaf_moments_t* out);
+
+/* Moments of each of batch samples, as ddaf_moments_compute gives them */
+void ddaf_moments_batched(const float* x, size_t batch, size_t sample_size,
+                          ddaf_moments_t* out);
+
+/* Piecewise polynomial table: y = c0 + f*(c1 + f*(c2 + f*c3)) per segment */
+typedef struct {
+    float x_min;
+    float x_max;
+    float inv_step;
+    float u_max;            /* n_segments as float, upper clamp of u */
+    size_t n_segments;
+    size_t stride;          /* coefficients per segment: 2 linear, 4 cubic */
+    float tail_slope;       /* dy/dx beyond x_max */
+    float* coeffs;
+} ddaf_lut_t;
+
+/* Frozen activation of a core context (ctx->baked) */
+typedef struct {
+    ddaf_lut_t gelu;
+    ddaf_lut_t swish;
+    ddaf_lut_t combined;    /* Whole activation at default parameters */
+    bool uniform;           /* Every element can use the combined table */
+    float* damping;         /* Dynamic: 1 / (1 + |p_i|) per parameter */
+} ddaf_baked_t;
+
+static inline float ddaf_lut_eval(const ddaf_lut_t* lut, float x) {
+    float u = (x - lut->x_min) * lut->inv_step;
+    u = DDAF_MAX(0.0f, DDAF_MIN(lut->u_max, u));
+    
+    size_t k = DDAF_MIN((size_t)u, lut->n_segments - 1);
+    float f = u - (float)k;
+    const float* c = lut->coeffs + k * lut->stride;
+    
+    float y = (lut->stride == 2) ? c[0] + f * c[1]
+                                 : c[0] + f * (c[1] + f * (c[2] + f * c[3]));
+    return y + lut->tail_slope * DDAF_MAX(0.0f, x - lut->x_max);
+}
+
+/* Array kernel table selected by CPU dispatch, one per precision tier */
+#define DDAF_PRECISION_COUNT 3
+
+typedef void (*ddaf_kernel_fn)(const float* input, float* output, size_t n);
+typedef void (*ddaf_lut_kernel_fn)(const ddaf_lut_t* lut, const float* input,
+                                   float* output, size_t n);
+
+typedef struct {
+    ddaf_kernel_fn gelu;
+    ddaf_kernel_fn swish;
+    ddaf_kernel_fn sigmoid;
+    ddaf_kernel_fn tanh;
+    ddaf_kernel_fn exp;
+    ddaf_lut_kernel_fn lut;     /* Baked table interpolation (gather + FMA) */
+} ddaf_kernel_table_t;
+
+const ddaf_kernel_table_t* ddaf_get_kernels(ddaf_precision_t precision);
+
+/* 16-bit storage conversion, selected along with the kernel tables */
+#define DDAF_DTYPE_COUNT 2
+
+typedef void (*ddaf_widen_fn)(const uint16_t* input, float* output, size_t n);
+typedef void (*ddaf_narrow_fn)(const float* input, uint16_t* output, size_t n);
+
+typedef struct {
+    ddaf_widen_fn widen[DDAF_DTYPE_COUNT];
+    ddaf_narrow_fn narrow[DDAF_DTYPE_COUNT];
+} ddaf_convert_table_t;
+
+void ddaf_widen(ddaf_dtype_t dtype, const uint16_t* input, float* output,
+                size_t n);
+void ddaf_narrow(ddaf_dtype_t dtype, const float* input, uint16_t* output,
+                 size_t n);
+
+/* Default initial pool size of a context */
+#define DDAF_DEFAULT_POOL_SIZE (1024 * 1024)
+
+/* Pool slab header, stored at the start of its own allocation */
+struct ddaf_pool_slab {
+    struct ddaf_pool_slab* next;
+    char* data;             /* Aligned to the pool alignment */
+    size_t start;           /* Global offset of data[0] */
+    size_t capacity;
+    size_t mapped;          /* mmap length, 0 for heap slabs */
+};
+
+/*
+ * Serve a pool from caller memory: until ddaf_pool_unbind, allocations
+ * come from buffer and fail instead of growing the pool. Bindings nest.
+ */
+typedef struct {
+    ddaf_memory_pool_t saved;
+    ddaf_pool_slab_t slab;
+} ddaf_pool_binding_t;
+
+void ddaf_pool_bind(ddaf_memory_pool_t* pool, void* buffer, size_t size,
+                    ddaf_pool_binding_t* binding);
+void ddaf_pool_unbind(ddaf_memory_pool_t* pool,
+                      const ddaf_pool_binding_t* binding);
+
+/*
+ * Workspace of a nested call, without the alignment slack added by the
+ * public queries. Architecture hooks sum their own pool allocations
+ * (rounded by ddaf_workspace_floats) with the peak of their children.
+ */
+size_t ddaf_child_forward_workspace(const ddaf_context_t* ctx, size_t size);
+size_t ddaf_child_backward_workspace(const ddaf_context_t* ctx, size_t size);
+size_t ddaf_workspace_floats(const ddaf_context_t* ctx, size_t count);
+
+/*
+ * Saved forward inputs. ddaf_forward calls ddaf_save_input before the
+ * type's forward (so in-place calls are covered). Backward passes get the
+ * input of the last forward from ddaf_saved_input: the stored copy, a
+ * decoded or rebuilt one in pool scratch, or NULL if none was kept.
+ */
+void ddaf_save_input(ddaf_context_t* ctx, const float* input, size_t size);
+void ddaf_save_input16(ddaf_context_t* ctx, const uint16_t* input,
+                       size_t size, ddaf_dtype_t dtype);
+const float* ddaf_saved_input(ddaf_context_t* ctx, size_t size);
+void ddaf_discard_saved(ddaf_context_t* ctx);
+
+/* Pool bytes ddaf_saved_input may take; the backward hook of core types */
+size_t ddaf_saved_input_workspace(const ddaf_context_t* ctx, size_t size);
+
+/* Recompute hook of architectures that pass their input on unchanged */
+int ddaf_recompute_passthrough(ddaf_context_t* ctx, const ddaf_context_t* child,
+                               float* input, size_t size);
+
+/*
+ * Thread pool. fn runs once per chunk of grain elements (the last may be
+ * short) with [begin, end) in element indices, on the caller or a worker.
+ * Tasks must not touch a context's pool; nested calls run inline.
+ */
+typedef void (*ddaf_task_fn)(void* arg, size_t begin, size_t end);
+
+void ddaf_parallel_for(size_t count, size_t grain, ddaf_task_fn fn, void* arg);
+
+/* Pool worker running the current task: 0 for the caller, < thread count */
+size_t ddaf_worker_index(void);
+
+/*
+ * Blocked elementwise sweep over size elements in DDAF_PARALLEL_GRAIN
+ * chunks: block gets DDAF_KERNEL_BLOCK elements at a time with their
+ * offset, and output may be input. The 16-bit form widens into a stack
+ * block, calls block in place and narrows the result.
+ */
+typedef void (*ddaf_block_fn)(void* arg, const float* input, float* output,
+                              size_t start, size_t n);
+
+void ddaf_parallel_sweep(size_t size, ddaf_block_fn block, void* arg,
+                         const float* input, float* output);
+void ddaf_parallel_sweep16(size_t size, ddaf_block_fn block, void* arg,
+                           const uint16_t* input, uint16_t* output,
+                           ddaf_dtype_t dtype);
+
+/*
+ * Batched forms: each sample is split at the chunks an unbatched call on
+ * it would use, and short samples are grouped up to a chunk. fn gets
+ * positions [begin, end) of one sample. The sweep passes block the
+ * positions within the sample and args + sample * arg_stride, so a
+ * stride of 0 shares one argument.
+ */
+typedef void (*ddaf_sample_fn)(void* arg, size_t sample, size_t begin,
+                               size_t end);
+
+void ddaf_parallel_samples(size_t batch, size_t sample_size, ddaf_sample_fn fn,
+                           void* arg);
+void ddaf_parallel_sweep_batched(size_t batch, size_t sample_size,
+                                 ddaf_block_fn block, void* args,
+                                 size_t arg_stride, const float* input,
+                                 float* output);
+
+/*
+ * Run ctx's forward with state updates (statistics, buffers) suppressed,
+ * in the batch shape of its last call
+ */
+int ddaf_replay_forward(ddaf_context_t* ctx, const float* input, float* output,
+                        size_t size);
+
+/*
+ * Nested calls in the batch shape of the parent's current call: size
+ * elements split into parent->batch samples
+ */
+int ddaf_child_forward(const ddaf_context_t* parent, ddaf_context_t* child,
+                       const float* input, float* output, size_t size);
+int ddaf_child_backward(const ddaf_context_t* parent, ddaf_context_t* child,
+                        const float* grad_output, float* grad_input,
+                        size_t size);
+
+/*
+ * Batched hooks of contexts that treat the batch as one tensor: the flat
+ * pass, with nested contexts called through ddaf_child_forward/backward
+ */
+int ddaf_batch_forward_flat(ddaf_context_t* ctx, const float* input,
+                            float* output, size_t batch, size_t sample_size,
+                            unsigned flags);
+int ddaf_batch_backward_flat(ddaf_context_t* ctx, const float* grad_output,
+                             float* grad_input, size_t batch,
+                             size_t sample_size, unsigned flags);
+
+/*
+ * Recurrent state of each sample of the current batch: ctx->batch copies
+ * of per_sample floats. When the batch size changes every copy restarts
+ * from initial (zeros if NULL). NULL if the block cannot be allocated.
+ */
+float* ddaf_batch_state(ddaf_context_t* ctx, size_t per_sample,
+                        const float* initial);
+
+/* Allocator callbacks with the libc fallback */
+static inline void* ddaf_allocator_malloc(const ddaf_allocator_t* allocator,
+                                          size_t size) {
+    if (allocator && allocator->malloc_fn) {
+        return allocator->malloc_fn(size, allocator->user_data);
+    }
+    return malloc(size);
+}
+
+static inline void ddaf_allocator_free(const ddaf_allocator_t* allocator,
+                                       void* ptr) {
+    if (!ptr) return;
+    if (allocator && allocator->free_fn) {
+        allocator->free_fn(ptr, allocator->user_data);
+    } else {
+        free(ptr);
+    }
+}
+
+/* Zeroed allocation through the context's allocator */
+void* ddaf_ctx_alloc(const ddaf_context_t* ctx, size_t size);
+void ddaf_ctx_free(const ddaf_context_t* ctx, void* ptr);
+
+/*
+ * Replace ctx->params with a zeroed block of the given size, reusing the
+ * old block through realloc_fn when possible. Returns the new block (also
+ * stored in ctx->params) or NULL with ctx->params cleared.
+ */
+void* ddaf_alloc_params(ddaf_context_t* ctx, size_t size);
+void ddaf_free_params(ddaf_context_t* ctx);
+
+/* True if ptr lies in the compacted block of ctx's tree (never freed alone) */
+bool ddaf_in_arena(const ddaf_context_t* ctx, const void* ptr);
+
+/* Old and new address of every block moved by ddaf_compact or mirrored
+ * by a session */
+typedef struct {
+    const char* old_base;
+    size_t size;
+    char* new_base;
+} ddaf_moved_block_t;
+
+struct ddaf_relocation {
+    const ddaf_moved_block_t* blocks;
+    size_t count;
+};
+
+/* New address of ptr, or ptr itself if it was not moved */
+void* ddaf_relocate_ptr(const ddaf_relocation_t* reloc, const void* ptr);
+void ddaf_relocate_baked(ddaf_baked_t* baked, const ddaf_relocation_t* reloc);
+
+/* Size of a context tree, and its contexts in depth-first order (a context
+ * precedes its children) from nodes[index]; returns the next index */
+size_t ddaf_tree_count(const ddaf_context_t* ctx);
+size_t ddaf_tree_collect(ddaf_context_t* ctx, ddaf_context_t** nodes,
+                         size_t index);
+
+/* Nested contexts: inherit type, arch, precision and creation options from
+ * the parent, borrow its pool and are destroyed with it */
+ddaf_context_t* ddaf_create_child_context(ddaf_context_t* parent);
+void ddaf_destroy_children(ddaf_context_t* ctx);
+
 #endif /* DDAF_INTERNAL_H */
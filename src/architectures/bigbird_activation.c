@@ -33,7 +33,8 @@ static int bigbird_forward(ddaf_context_t* ctx, const float* input,
     float* window_output = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
     if (!window_output) return -1;
     
-    int ret = ddaf_forward(params->activation_ctx, input, window_output, size);
+    int ret = ddaf_child_forward(ctx, params->activation_ctx, input,
+                                 window_output, size);
     if (ret != 0) return ret;
     
     /* Global attention */
@@ -41,28 +42,28 @@ static int bigbird_forward(ddaf_context_t* ctx, const float* input,
     if (params->global_activation_ctx) {
         global_output = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
         if (!global_output) return -1;
-        ret = ddaf_forward(params->global_activation_ctx, input, global_output, size);
+        ret = ddaf_child_forward(ctx, params->global_activation_ctx, input,
+                                 global_output, size);
         if (ret != 0) return ret;
     }
     
-    /* Random attention */
-    float* random_output = NULL;
+    /* Random attention reads input last, so it can write output directly */
     if (params->random_activation_ctx) {
-        random_output = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-        if (!random_output) return -1;
-        ret = ddaf_forward(params->random_activation_ctx, input, random_output, size);
+        ret = ddaf_child_forward(ctx, params->random_activation_ctx, input,
+                                 output, size);
         if (ret != 0) return ret;
     }
     
     /* Combine outputs */
     for (size_t i = 0; i < size; i++) {
-        output[i] = window_output[i];
+        float combined = window_output[i];
         if (global_output) {
-            output[i] += 0.3f * global_output[i];
+            combined += 0.3f * global_output[i];
         }
-        if (random_output) {
-            output[i] += 0.2f * random_output[i];
+        if (params->random_activation_ctx) {
+            combined += 0.2f * output[i];
         }
+        output[i] = combined;
     }
     
     return 0;
@@ -73,21 +74,60 @@ static int bigbird_backward(ddaf_context_t* ctx, const float* grad_output,
     bigbird_params_t* params = (bigbird_params_t*)ctx->params;
     if (!params || !params->activation_ctx) return -1;
     
-    float* grad_window = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-    if (!grad_window) return -1;
+    float scale = 1.0f;
+    if (params->global_activation_ctx) {
+        scale += 0.3f;
+    }
+    if (params->random_activation_ctx) {
+        scale += 0.2f;
+    }
     
-    /* Distribute gradient */
+    /* Distribute gradient, then back through the window activation in place */
     for (size_t i = 0; i < size; i++) {
-        grad_window[i] = grad_output[i];
-        if (params->global_activation_ctx) {
-            grad_window[i] += 0.3f * grad_output[i];
-        }
-        if (params->random_activation_ctx) {
-            grad_window[i] += 0.2f * grad_output[i];
-        }
+        grad_input[i] = grad_output[i] * scale;
+    }
+    
+    return ddaf_child_backward(ctx, params->activation_ctx, grad_input,
+                               grad_input, size);
+}
+
+/* Window and global outputs stay live; the random branch writes output */
+static size_t bigbird_forward_workspace(const ddaf_context_t* ctx,
+                                        size_t size) {
+    const bigbird_params_t* params = (const bigbird_params_t*)ctx->params;
+    size_t buffer = ddaf_workspace_floats(ctx, size);
+    size_t peak = buffer +
+                  ddaf_child_forward_workspace(params->activation_ctx, size);
+    size_t live = buffer;
+    
+    if (params->global_activation_ctx) {
+        live += buffer;
+        peak = DDAF_MAX(peak, live + ddaf_child_forward_workspace(
+            params->global_activation_ctx, size));
+    }
+    if (params->random_activation_ctx) {
+        peak = DDAF_MAX(peak, live + ddaf_child_forward_workspace(
+            params->random_activation_ctx, size));
     }
     
-    return ddaf_backward(params->activation_ctx, grad_window, grad_input, size);
+    return peak;
+}
+
+static size_t bigbird_backward_workspace(const ddaf_context_t* ctx,
+                                         size_t size) {
+    const bigbird_params_t* params = (const bigbird_params_t*)ctx->params;
+    return ddaf_child_backward_workspace(params->activation_ctx, size);
+}
+
+static void bigbird_relocate(ddaf_context_t* ctx,
+                             const ddaf_relocation_t* reloc) {
+    bigbird_params_t* params = (bigbird_params_t*)ctx->params;
+    
+    params->activation_ctx = ddaf_relocate_ptr(reloc, params->activation_ctx);
+    params->global_activation_ctx =
+        ddaf_relocate_ptr(reloc, params->global_activation_ctx);
+    params->random_activation_ctx =
+        ddaf_relocate_ptr(reloc, params->random_activation_ctx);
 }
 
 int ddaf_bigbird_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
@@ -97,11 +137,8 @@ int ddaf_bigbird_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
     if (block_size == 0) return -1;
     
     size_t param_size = sizeof(bigbird_params_t);
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     bigbird_params_t* params = (bigbird_params_t*)ctx->params;
@@ -111,27 +148,24 @@ int ddaf_bigbird_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
     params->block_size = block_size;
     
     /* Create activation contexts for different attention types */
-    params->activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->activation_ctx = ddaf_create_child_context(ctx);
     if (!params->activation_ctx) {
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
-    params->global_activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->global_activation_ctx = ddaf_create_child_context(ctx);
     if (!params->global_activation_ctx) {
         ddaf_destroy_context(params->activation_ctx);
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
-    params->random_activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->random_activation_ctx = ddaf_create_child_context(ctx);
     if (!params->random_activation_ctx) {
         ddaf_destroy_context(params->global_activation_ctx);
         ddaf_destroy_context(params->activation_ctx);
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
@@ -165,13 +199,18 @@ int ddaf_bigbird_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
             ddaf_destroy_context(params->random_activation_ctx);
             ddaf_destroy_context(params->global_activation_ctx);
             ddaf_destroy_context(params->activation_ctx);
-            free(ctx->params);
-            ctx->params = NULL;
+            ddaf_free_params(ctx);
             return -1;
     }
     
     ctx->forward = bigbird_forward;
     ctx->backward = bigbird_backward;
+    ctx->relocate = bigbird_relocate;
+    ctx->forward_workspace = bigbird_forward_workspace;
+    ctx->backward_workspace = bigbird_backward_workspace;
+    ctx->recompute = ddaf_recompute_passthrough;
+    ctx->forward_batched = ddaf_batch_forward_flat;
+    ctx->backward_batched = ddaf_batch_backward_flat;
     
     return 0;
 }
@@ -23,7 +23,7 @@ static int cnn_forward(ddaf_context_t* ctx, const float* input,
     if (!params || !params->activation_ctx) return -1;
     
     /* Apply activation function to CNN feature maps */
-    return ddaf_forward(params->activation_ctx, input, output, size);
+    return ddaf_child_forward(ctx, params->activation_ctx, input, output, size);
 }
 
 static int cnn_backward(ddaf_context_t* ctx, const float* grad_output,
@@ -31,7 +31,25 @@ static int cnn_backward(ddaf_context_t* ctx, const float* grad_output,
     cnn_params_t* params = (cnn_params_t*)ctx->params;
     if (!params || !params->activation_ctx) return -1;
     
-    return ddaf_backward(params->activation_ctx, grad_output, grad_input, size);
+    return ddaf_child_backward(ctx, params->activation_ctx, grad_output,
+                               grad_input, size);
+}
+
+static size_t cnn_forward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const cnn_params_t* params = (const cnn_params_t*)ctx->params;
+    return ddaf_child_forward_workspace(params->activation_ctx, size);
+}
+
+static size_t cnn_backward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const cnn_params_t* params = (const cnn_params_t*)ctx->params;
+    return ddaf_child_backward_workspace(params->activation_ctx, size);
+}
+
+static void cnn_relocate(ddaf_context_t* ctx,
+                         const ddaf_relocation_t* reloc) {
+    cnn_params_t* params = (cnn_params_t*)ctx->params;
+    
+    params->activation_ctx = ddaf_relocate_ptr(reloc, params->activation_ctx);
 }
 
 int ddaf_cnn_init(ddaf_context_t* ctx, size_t channels, size_t height, 
@@ -39,11 +57,8 @@ int ddaf_cnn_init(ddaf_context_t* ctx, size_t channels, size_t height,
     if (!ctx) return -1;
     
     size_t param_size = sizeof(cnn_params_t);
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     cnn_params_t* params = (cnn_params_t*)ctx->params;
@@ -53,11 +68,10 @@ int ddaf_cnn_init(ddaf_context_t* ctx, size_t channels, size_t height,
     
     /* Create activation context based on type */
     size_t feature_size = channels * height * width;
-    params->activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->activation_ctx = ddaf_create_child_context(ctx);
     
     if (!params->activation_ctx) {
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
@@ -77,14 +91,19 @@ int ddaf_cnn_init(ddaf_context_t* ctx, size_t channels, size_t height,
                                height * width);
             break;
         default:
-            free(ctx->params);
-            ctx->params = NULL;
             ddaf_destroy_context(params->activation_ctx);
+            ddaf_free_params(ctx);
             return -1;
     }
     
     ctx->forward = cnn_forward;
     ctx->backward = cnn_backward;
+    ctx->relocate = cnn_relocate;
+    ctx->forward_workspace = cnn_forward_workspace;
+    ctx->backward_workspace = cnn_backward_workspace;
+    ctx->recompute = ddaf_recompute_passthrough;
+    ctx->forward_batched = ddaf_batch_forward_flat;
+    ctx->backward_batched = ddaf_batch_backward_flat;
     
     return 0;
 }
@@ -17,6 +17,24 @@ typedef struct {
     ddaf_context_t* activation_ctx;
 } gru_params_t;
 
+/*
+ * Gates of unit i come from input[i + k * hidden_size] and only
+ * output[i] is written, so one fused pass is safe when input == output
+ */
+static void gru_step(const float* input, const float* hidden_state,
+                     float* output, size_t hidden_size) {
+    for (size_t i = 0; i < hidden_size; i++) {
+        float old_hidden = hidden_state ? hidden_state[i] : 0.0f;
+        float reset_gate = ddaf_sigmoid(input[i]);
+        float update_gate = ddaf_sigmoid(input[hidden_size + i]);
+        float candidate = ddaf_tanh(input[2 * hidden_size + i] +
+                                    reset_gate * old_hidden);
+        
+        /* Update hidden state */
+        output[i] = (1.0f - update_gate) * candidate + update_gate * old_hidden;
+    }
+}
+
 static int gru_forward(ddaf_context_t* ctx, const float* input,
                       float* output, size_t size) {
     gru_params_t* params = (gru_params_t*)ctx->params;
@@ -25,41 +43,50 @@ static int gru_forward(ddaf_context_t* ctx, const float* input,
     size_t hidden_size = params->hidden_size;
     if (size < hidden_size * 3) return -1;
     
-    /* GRU gates: reset and update */
-    float* reset_gate = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    float* update_gate = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    float* candidate = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    if (!reset_gate || !update_gate || !candidate) return -1;
+    gru_step(input, params->hidden_state, output, hidden_size);
     
-    /* Compute gates */
-    for (size_t i = 0; i < hidden_size; i++) {
-        reset_gate[i] = ddaf_sigmoid(input[i]);
-        update_gate[i] = ddaf_sigmoid(input[hidden_size + i]);
-        
-        float reset_hidden = reset_gate[i] * 
-                            (params->hidden_state ? params->hidden_state[i] : 0.0f);
-        candidate[i] = ddaf_tanh(input[2 * hidden_size + i] + reset_hidden);
-    }
+    /* Apply main activation function in place */
+    int ret = ddaf_forward(params->activation_ctx, output, output, hidden_size);
     
     /* Update hidden state */
-    for (size_t i = 0; i < hidden_size; i++) {
-        float old_hidden = params->hidden_state ? params->hidden_state[i] : 0.0f;
-        output[i] = (1.0f - update_gate[i]) * candidate[i] + 
-                   update_gate[i] * old_hidden;
+    if (params->hidden_state && hidden_size <= params->hidden_size) {
+        memcpy(params->hidden_state, output, hidden_size * sizeof(float));
     }
     
-    /* Apply main activation function */
-    float* temp_output = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    if (!temp_output) return -1;
+    return ret;
+}
+
+/*
+ * Each sample steps its own hidden state; the hidden units of all samples
+ * are packed side by side for one activation call
+ */
+static int gru_forward_batched(ddaf_context_t* ctx, const float* input,
+                               float* output, size_t batch, size_t sample_size,
+                               unsigned flags) {
+    (void)flags;
+    gru_params_t* params = (gru_params_t*)ctx->params;
+    if (!params || !params->activation_ctx) return -1;
     
-    int ret = ddaf_forward(params->activation_ctx, output, temp_output, hidden_size);
-    if (ret == 0) {
-        memcpy(output, temp_output, hidden_size * sizeof(float));
+    size_t hidden_size = params->hidden_size;
+    if (sample_size < hidden_size * 3) return -1;
+    
+    float* state = ddaf_batch_state(ctx, hidden_size, params->hidden_state);
+    float* packed = (float*)ddaf_pool_alloc(ctx->pool, batch * hidden_size *
+                                                       sizeof(float));
+    if (!state || !packed) return -1;
+    
+    for (size_t b = 0; b < batch; b++) {
+        gru_step(input + b * sample_size, state + b * hidden_size,
+                 packed + b * hidden_size, hidden_size);
     }
     
-    /* Update hidden state */
-    if (params->hidden_state && hidden_size <= params->hidden_size) {
-        memcpy(params->hidden_state, output, hidden_size * sizeof(float));
+    int ret = ddaf_child_forward(ctx, params->activation_ctx, packed, packed,
+                                 batch * hidden_size);
+    
+    for (size_t b = 0; b < batch; b++) {
+        const float* hidden = packed + b * hidden_size;
+        memcpy(output + b * sample_size, hidden, hidden_size * sizeof(float));
+        memcpy(state + b * hidden_size, hidden, hidden_size * sizeof(float));
     }
     
     return ret;
@@ -71,33 +98,83 @@ static int gru_backward(ddaf_context_t* ctx, const float* grad_output,
     if (!params || !params->activation_ctx) return -1;
     
     size_t hidden_size = params->hidden_size;
-    if (size < hidden_size) return -1;
+    if (size < hidden_size * 3) return -1;
+    
+    int ret = ddaf_backward(params->activation_ctx, grad_output, grad_input,
+                            hidden_size);
+    if (ret != 0) return ret;
+    
+    /* Backward through GRU gates: update and candidate share it */
+    for (size_t k = 1; k < 3; k++) {
+        memcpy(grad_input + k * hidden_size, grad_input,
+               hidden_size * sizeof(float));
+    }
+    
+    return 0;
+}
+
+static int gru_backward_batched(ddaf_context_t* ctx, const float* grad_output,
+                                float* grad_input, size_t batch,
+                                size_t sample_size, unsigned flags) {
+    (void)flags;
+    gru_params_t* params = (gru_params_t*)ctx->params;
+    if (!params || !params->activation_ctx) return -1;
+    
+    size_t hidden_size = params->hidden_size;
+    if (sample_size < hidden_size * 3) return -1;
     
-    float* grad_temp = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    if (!grad_temp) return -1;
+    float* packed = (float*)ddaf_pool_alloc(ctx->pool, batch * hidden_size *
+                                                       sizeof(float));
+    if (!packed) return -1;
     
-    int ret = ddaf_backward(params->activation_ctx, grad_output, grad_temp, hidden_size);
+    for (size_t b = 0; b < batch; b++) {
+        memcpy(packed + b * hidden_size, grad_output + b * sample_size,
+               hidden_size * sizeof(float));
+    }
+    
+    int ret = ddaf_child_backward(ctx, params->activation_ctx, packed, packed,
+                                  batch * hidden_size);
     if (ret != 0) return ret;
     
-    /* Backward through GRU gates */
-    for (size_t i = 0; i < hidden_size; i++) {
-        grad_input[i] = grad_temp[i]; /* Reset gate */
-        grad_input[hidden_size + i] = grad_temp[i]; /* Update gate */
-        grad_input[2 * hidden_size + i] = grad_temp[i]; /* Candidate */
+    /* Every gate of a sample shares its hidden gradient */
+    for (size_t b = 0; b < batch; b++) {
+        for (size_t k = 0; k < 3; k++) {
+            memcpy(grad_input + b * sample_size + k * hidden_size,
+                   packed + b * hidden_size, hidden_size * sizeof(float));
+        }
     }
     
     return 0;
 }
 
+static size_t gru_forward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const gru_params_t* params = (const gru_params_t*)ctx->params;
+    (void)size;
+    return ddaf_child_forward_workspace(params->activation_ctx,
+                                        params->hidden_size);
+}
+
+static size_t gru_backward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const gru_params_t* params = (const gru_params_t*)ctx->params;
+    (void)size;
+    return ddaf_child_backward_workspace(params->activation_ctx,
+                                         params->hidden_size);
+}
+
+static void gru_relocate(ddaf_context_t* ctx,
+                         const ddaf_relocation_t* reloc) {
+    gru_params_t* params = (gru_params_t*)ctx->params;
+    
+    params->hidden_state = ddaf_relocate_ptr(reloc, params->hidden_state);
+    params->activation_ctx = ddaf_relocate_ptr(reloc, params->activation_ctx);
+}
+
 int ddaf_gru_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
     if (!ctx) return -1;
     
     size_t param_size = sizeof(gru_params_t) + hidden_size * sizeof(float);
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     gru_params_t* params = (gru_params_t*)ctx->params;
@@ -109,10 +186,9 @@ int ddaf_gru_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
     memset(params->hidden_state, 0, hidden_size * sizeof(float));
     
     /* Create activation context */
-    params->activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->activation_ctx = ddaf_create_child_context(ctx);
     if (!params->activation_ctx) {
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
@@ -131,14 +207,18 @@ int ddaf_gru_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
             ddaf_init_attention(params->activation_ctx, hidden_size, 4, seq_len);
             break;
         default:
-            free(ctx->params);
-            ctx->params = NULL;
             ddaf_destroy_context(params->activation_ctx);
+            ddaf_free_params(ctx);
             return -1;
     }
     
     ctx->forward = gru_forward;
     ctx->backward = gru_backward;
+    ctx->forward_batched = gru_forward_batched;
+    ctx->backward_batched = gru_backward_batched;
+    ctx->relocate = gru_relocate;
+    ctx->forward_workspace = gru_forward_workspace;
+    ctx->backward_workspace = gru_backward_workspace;
     
     return 0;
 }
@@ -24,22 +24,22 @@ static int hierarchical_transformer_forward(ddaf_context_t* ctx,
         (hierarchical_transformer_params_t*)ctx->params;
     if (!params || !params->level_activations) return -1;
     
-    /* Apply activations at each hierarchical level */
-    float* temp = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-    if (!temp) return -1;
-    
-    memcpy(temp, input, size * sizeof(float));
-    
+    /*
+     * The first level reads input and writes output, later levels run in
+     * place in output, so no level copies the tensor
+     */
+    const float* level_input = input;
     for (size_t level = 0; level < params->n_levels; level++) {
         if (!params->level_activations[level]) continue;
         
-        int ret = ddaf_forward(params->level_activations[level], temp, output, size);
+        int ret = ddaf_child_forward(ctx, params->level_activations[level],
+                                     level_input, output, size);
         if (ret != 0) return ret;
-        
-        /* Use output as input for next level */
-        if (level < params->n_levels - 1) {
-            memcpy(temp, output, size * sizeof(float));
-        }
+        level_input = output;
+    }
+    
+    if (level_input != output) {
+        memcpy(output, input, size * sizeof(float));
     }
     
     return 0;
@@ -52,29 +52,84 @@ static int hierarchical_transformer_backward(ddaf_context_t* ctx,
         (hierarchical_transformer_params_t*)ctx->params;
     if (!params || !params->level_activations) return -1;
     
-    /* Backward through hierarchical levels in reverse */
-    float* grad_temp = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-    if (!grad_temp) return -1;
-    
-    memcpy(grad_temp, grad_output, size * sizeof(float));
-    
+    /* Backward through the levels in reverse, in place after the first */
+    const float* level_grad = grad_output;
     for (int level = (int)params->n_levels - 1; level >= 0; level--) {
         if (!params->level_activations[level]) continue;
         
-        float* temp_input = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-        if (!temp_input) return -1;
-        
-        int ret = ddaf_backward(params->level_activations[level], grad_temp, 
-                               temp_input, size);
+        int ret = ddaf_child_backward(ctx, params->level_activations[level],
+                                      level_grad, grad_input, size);
         if (ret != 0) return ret;
-        
-        memcpy(grad_temp, temp_input, size * sizeof(float));
+        level_grad = grad_input;
+    }
+    
+    if (level_grad != grad_input) {
+        memcpy(grad_input, grad_output, size * sizeof(float));
     }
     
-    memcpy(grad_input, grad_temp, size * sizeof(float));
     return 0;
 }
 
+/* A level's input: the checkpoint replayed through the levels before it */
+static int hierarchical_transformer_recompute(ddaf_context_t* ctx,
+                                              const ddaf_context_t* child,
+                                              float* input, size_t size) {
+    hierarchical_transformer_params_t* params =
+        (hierarchical_transformer_params_t*)ctx->params;
+    
+    if (ddaf_recompute_passthrough(ctx, child, input, size) != 0) return -1;
+    
+    for (size_t level = 0; level < params->n_levels; level++) {
+        ddaf_context_t* activation = params->level_activations[level];
+        if (activation == child) return 0;
+        if (!activation) continue;
+        
+        if (ddaf_replay_forward(activation, input, input, size) != 0) {
+            return -1;
+        }
+    }
+    
+    return -1;
+}
+
+/* The deepest level call; the levels run in place and need no buffers */
+static size_t hierarchical_transformer_forward_workspace(
+    const ddaf_context_t* ctx, size_t size) {
+    const hierarchical_transformer_params_t* params =
+        (const hierarchical_transformer_params_t*)ctx->params;
+    size_t levels = 0;
+    for (size_t level = 0; level < params->n_levels; level++) {
+        levels = DDAF_MAX(levels, ddaf_child_forward_workspace(
+            params->level_activations[level], size));
+    }
+    return levels;
+}
+
+static size_t hierarchical_transformer_backward_workspace(
+    const ddaf_context_t* ctx, size_t size) {
+    const hierarchical_transformer_params_t* params =
+        (const hierarchical_transformer_params_t*)ctx->params;
+    size_t levels = 0;
+    for (size_t level = 0; level < params->n_levels; level++) {
+        levels = DDAF_MAX(levels, ddaf_child_backward_workspace(
+            params->level_activations[level], size));
+    }
+    return levels;
+}
+
+static void hierarchical_transformer_relocate(ddaf_context_t* ctx,
+                                              const ddaf_relocation_t* reloc) {
+    hierarchical_transformer_params_t* params =
+        (hierarchical_transformer_params_t*)ctx->params;
+    
+    params->level_activations =
+        ddaf_relocate_ptr(reloc, params->level_activations);
+    for (size_t i = 0; i < params->n_levels; i++) {
+        params->level_activations[i] =
+            ddaf_relocate_ptr(reloc, params->level_activations[i]);
+    }
+}
+
 int ddaf_hierarchical_transformer_init(ddaf_context_t* ctx, size_t d_model,
                                        size_t n_heads, size_t n_levels) {
     if (!ctx) return -1;
@@ -83,11 +138,8 @@ int ddaf_hierarchical_transformer_init(ddaf_context_t* ctx, size_t d_model,
     
     size_t param_size = sizeof(hierarchical_transformer_params_t) +
                         n_levels * sizeof(ddaf_context_t*);
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     hierarchical_transformer_params_t* params = 
@@ -100,14 +152,13 @@ int ddaf_hierarchical_transformer_init(ddaf_context_t* ctx, size_t d_model,
     
     /* Initialize activations for each level */
     for (size_t level = 0; level < n_levels; level++) {
-        params->level_activations[level] = ddaf_create_context(ctx->type, ctx->arch, 0);
+        params->level_activations[level] = ddaf_create_child_context(ctx);
         if (!params->level_activations[level]) {
             /* Cleanup on failure */
             for (size_t i = 0; i < level; i++) {
                 ddaf_destroy_context(params->level_activations[i]);
             }
-            free(ctx->params);
-            ctx->params = NULL;
+            ddaf_free_params(ctx);
             return -1;
         }
         
@@ -130,14 +181,19 @@ int ddaf_hierarchical_transformer_init(ddaf_context_t* ctx, size_t d_model,
                 for (size_t i = 0; i <= level; i++) {
                     ddaf_destroy_context(params->level_activations[i]);
                 }
-                free(ctx->params);
-                ctx->params = NULL;
+                ddaf_free_params(ctx);
                 return -1;
         }
     }
     
     ctx->forward = hierarchical_transformer_forward;
     ctx->backward = hierarchical_transformer_backward;
+    ctx->relocate = hierarchical_transformer_relocate;
+    ctx->forward_workspace = hierarchical_transformer_forward_workspace;
+    ctx->backward_workspace = hierarchical_transformer_backward_workspace;
+    ctx->recompute = hierarchical_transformer_recompute;
+    ctx->forward_batched = ddaf_batch_forward_flat;
+    ctx->backward_batched = ddaf_batch_backward_flat;
     
     return 0;
 }
@@ -19,6 +19,29 @@ typedef struct {
     ddaf_context_t* gate_activation_ctx;
 } lstm_params_t;
 
+/*
+ * Gates of unit i come from input[i + k * hidden_size] and only
+ * output[i] is written, so one fused pass is safe when input == output
+ */
+static void lstm_step(const float* input, float* cell_state, float* output,
+                      size_t hidden_size) {
+    for (size_t i = 0; i < hidden_size; i++) {
+        float input_gate = ddaf_sigmoid(input[i]);
+        float forget_gate = ddaf_sigmoid(input[hidden_size + i]);
+        float output_gate = ddaf_sigmoid(input[2 * hidden_size + i]);
+        float candidate = ddaf_tanh(input[3 * hidden_size + i]);
+        
+        /* Update cell state and hidden state */
+        float cell_act = 0.0f;
+        if (cell_state) {
+            cell_state[i] = forget_gate * cell_state[i] +
+                            input_gate * candidate;
+            cell_act = ddaf_tanh(cell_state[i]);
+        }
+        output[i] = output_gate * cell_act;
+    }
+}
+
 static int lstm_forward(ddaf_context_t* ctx, const float* input,
                        float* output, size_t size) {
     lstm_params_t* params = (lstm_params_t*)ctx->params;
@@ -27,45 +50,52 @@ static int lstm_forward(ddaf_context_t* ctx, const float* input,
     size_t hidden_size = params->hidden_size;
     if (size < hidden_size * 4) return -1;
     
-    /* LSTM gates: input, forget, output, candidate */
-    float* gates = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * 4 * sizeof(float));
-    if (!gates) return -1;
+    lstm_step(input, params->cell_state, output, hidden_size);
     
-    /* Apply gate activations (sigmoid for input/forget/output, tanh for candidate) */
-    for (size_t i = 0; i < hidden_size; i++) {
-        /* Input gate */
-        gates[i] = ddaf_sigmoid(input[i]);
-        /* Forget gate */
-        gates[hidden_size + i] = ddaf_sigmoid(input[hidden_size + i]);
-        /* Output gate */
-        gates[2 * hidden_size + i] = ddaf_sigmoid(input[2 * hidden_size + i]);
-        /* Candidate */
-        gates[3 * hidden_size + i] = ddaf_tanh(input[3 * hidden_size + i]);
-    }
+    /* Apply main activation function in place */
+    int ret = ddaf_forward(params->activation_ctx, output, output, hidden_size);
     
-    /* Update cell state and hidden state */
-    for (size_t i = 0; i < hidden_size; i++) {
-        if (params->cell_state) {
-            params->cell_state[i] = gates[hidden_size + i] * params->cell_state[i] +
-                                   gates[i] * gates[3 * hidden_size + i];
-        }
-        
-        float cell_act = params->cell_state ? ddaf_tanh(params->cell_state[i]) : 0.0f;
-        output[i] = gates[2 * hidden_size + i] * cell_act;
+    /* Update hidden state */
+    if (params->hidden_state && hidden_size <= params->hidden_size) {
+        memcpy(params->hidden_state, output, hidden_size * sizeof(float));
     }
     
-    /* Apply main activation function */
-    float* temp_output = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    if (!temp_output) return -1;
+    return ret;
+}
+
+/*
+ * Each sample steps its own cell and hidden state; the hidden units of
+ * all samples are packed side by side for one activation call
+ */
+static int lstm_forward_batched(ddaf_context_t* ctx, const float* input,
+                                float* output, size_t batch,
+                                size_t sample_size, unsigned flags) {
+    (void)flags;
+    lstm_params_t* params = (lstm_params_t*)ctx->params;
+    if (!params || !params->activation_ctx) return -1;
+    
+    size_t hidden_size = params->hidden_size;
+    if (sample_size < hidden_size * 4) return -1;
+    
+    /* Per sample: cell state, then hidden state, as in params */
+    float* state = ddaf_batch_state(ctx, 2 * hidden_size, params->cell_state);
+    float* packed = (float*)ddaf_pool_alloc(ctx->pool, batch * hidden_size *
+                                                       sizeof(float));
+    if (!state || !packed) return -1;
     
-    int ret = ddaf_forward(params->activation_ctx, output, temp_output, hidden_size);
-    if (ret == 0) {
-        memcpy(output, temp_output, hidden_size * sizeof(float));
+    for (size_t b = 0; b < batch; b++) {
+        lstm_step(input + b * sample_size, state + 2 * b * hidden_size,
+                  packed + b * hidden_size, hidden_size);
     }
     
-    /* Update hidden state */
-    if (params->hidden_state && hidden_size <= params->hidden_size) {
-        memcpy(params->hidden_state, output, hidden_size * sizeof(float));
+    int ret = ddaf_child_forward(ctx, params->activation_ctx, packed, packed,
+                                 batch * hidden_size);
+    
+    for (size_t b = 0; b < batch; b++) {
+        const float* hidden = packed + b * hidden_size;
+        memcpy(output + b * sample_size, hidden, hidden_size * sizeof(float));
+        memcpy(state + (2 * b + 1) * hidden_size, hidden,
+               hidden_size * sizeof(float));
     }
     
     return ret;
@@ -77,35 +107,88 @@ static int lstm_backward(ddaf_context_t* ctx, const float* grad_output,
     if (!params || !params->activation_ctx) return -1;
     
     size_t hidden_size = params->hidden_size;
-    if (size < hidden_size) return -1;
+    if (size < hidden_size * 4) return -1;
+    
+    int ret = ddaf_backward(params->activation_ctx, grad_output, grad_input,
+                            hidden_size);
+    if (ret != 0) return ret;
+    
+    /* Backward through LSTM gates: forget, output and candidate share it */
+    for (size_t k = 1; k < 4; k++) {
+        memcpy(grad_input + k * hidden_size, grad_input,
+               hidden_size * sizeof(float));
+    }
+    
+    return 0;
+}
+
+static int lstm_backward_batched(ddaf_context_t* ctx,
+                                 const float* grad_output, float* grad_input,
+                                 size_t batch, size_t sample_size,
+                                 unsigned flags) {
+    (void)flags;
+    lstm_params_t* params = (lstm_params_t*)ctx->params;
+    if (!params || !params->activation_ctx) return -1;
+    
+    size_t hidden_size = params->hidden_size;
+    if (sample_size < hidden_size * 4) return -1;
     
-    float* grad_temp = (float*)ddaf_pool_alloc(ctx->pool, hidden_size * sizeof(float));
-    if (!grad_temp) return -1;
+    float* packed = (float*)ddaf_pool_alloc(ctx->pool, batch * hidden_size *
+                                                       sizeof(float));
+    if (!packed) return -1;
     
-    int ret = ddaf_backward(params->activation_ctx, grad_output, grad_temp, hidden_size);
+    for (size_t b = 0; b < batch; b++) {
+        memcpy(packed + b * hidden_size, grad_output + b * sample_size,
+               hidden_size * sizeof(float));
+    }
+    
+    int ret = ddaf_child_backward(ctx, params->activation_ctx, packed, packed,
+                                  batch * hidden_size);
     if (ret != 0) return ret;
     
-    /* Backward through LSTM gates */
-    for (size_t i = 0; i < hidden_size; i++) {
-        grad_input[i] = grad_temp[i]; /* Input gate */
-        grad_input[hidden_size + i] = grad_temp[i]; /* Forget gate */
-        grad_input[2 * hidden_size + i] = grad_temp[i]; /* Output gate */
-        grad_input[3 * hidden_size + i] = grad_temp[i]; /* Candidate */
+    /* Every gate of a sample shares its hidden gradient */
+    for (size_t b = 0; b < batch; b++) {
+        for (size_t k = 0; k < 4; k++) {
+            memcpy(grad_input + b * sample_size + k * hidden_size,
+                   packed + b * hidden_size, hidden_size * sizeof(float));
+        }
     }
     
     return 0;
 }
 
+static size_t lstm_forward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const lstm_params_t* params = (const lstm_params_t*)ctx->params;
+    (void)size;
+    return ddaf_child_forward_workspace(params->activation_ctx,
+                                        params->hidden_size);
+}
+
+static size_t lstm_backward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const lstm_params_t* params = (const lstm_params_t*)ctx->params;
+    (void)size;
+    return ddaf_child_backward_workspace(params->activation_ctx,
+                                         params->hidden_size);
+}
+
+static void lstm_relocate(ddaf_context_t* ctx,
+                          const ddaf_relocation_t* reloc) {
+    lstm_params_t* params = (lstm_params_t*)ctx->params;
+    
+    params->cell_state = ddaf_relocate_ptr(reloc, params->cell_state);
+    params->hidden_state = ddaf_relocate_ptr(reloc, params->hidden_state);
+    params->activation_ctx = ddaf_relocate_ptr(reloc, params->activation_ctx);
+    params->gate_activation_ctx =
+        ddaf_relocate_ptr(reloc, params->gate_activation_ctx);
+}
+
 int ddaf_lstm_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
     if (!ctx) return -1;
     
     size_t param_size = sizeof(lstm_params_t) + 
                         hidden_size * sizeof(float) * 2; /* cell + hidden state */
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     lstm_params_t* params = (lstm_params_t*)ctx->params;
@@ -119,10 +202,9 @@ int ddaf_lstm_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
     memset(params->hidden_state, 0, hidden_size * sizeof(float));
     
     /* Create activation contexts */
-    params->activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->activation_ctx = ddaf_create_child_context(ctx);
     if (!params->activation_ctx) {
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
@@ -141,14 +223,18 @@ int ddaf_lstm_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
             ddaf_init_attention(params->activation_ctx, hidden_size, 4, seq_len);
             break;
         default:
-            free(ctx->params);
-            ctx->params = NULL;
             ddaf_destroy_context(params->activation_ctx);
+            ddaf_free_params(ctx);
             return -1;
     }
     
     ctx->forward = lstm_forward;
     ctx->backward = lstm_backward;
+    ctx->forward_batched = lstm_forward_batched;
+    ctx->backward_batched = lstm_backward_batched;
+    ctx->relocate = lstm_relocate;
+    ctx->forward_workspace = lstm_forward_workspace;
+    ctx->backward_workspace = lstm_backward_workspace;
     
     return 0;
 }
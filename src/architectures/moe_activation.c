@@ -15,34 +15,233 @@ typedef struct {
     size_t n_experts;
     size_t k_experts;
     ddaf_context_t** expert_activations;
-    float* router_weights;
-    float* expert_outputs;
+    size_t* selected;           /* Top-k expert indices, best first */
+    float* router_weights;      /* Dense gate, zero outside the top k */
+    float* selected_weights;    /* Gate of each selected expert */
+    float* expert_outputs;      /* One row per selected expert */
+    float capacity_factor;      /* Batched bucket limit, <= 0 for none */
+    const float* rebuilt;       /* Backward: own input, rebuilt for experts */
 } moe_params_t;
 
+/*
+ * Scratch of one pool worker while experts run concurrently: a slice of
+ * the shared pool bound as a pool of its own, so experts on different
+ * threads never allocate from the same pool
+ */
+typedef struct {
+    ddaf_memory_pool_t pool;
+    ddaf_pool_binding_t binding;
+} moe_arena_t;
+
+/* Expert work sharing: one expert per task, with stealing between workers */
+typedef struct {
+    moe_params_t* params;
+    moe_arena_t* arenas;
+    const float* input;
+    float* output;
+    const size_t* rows;         /* Batch: first row of each expert's bucket */
+    const size_t* counts;       /* Batch: rows per expert */
+    int* status;                /* Result of each task */
+} moe_tasks_t;
+
+/*
+ * Route one token: score every expert, keep the k best and renormalize the
+ * softmax over them. Experts outside the top k get a zero gate and are
+ * never evaluated.
+ */
 static void compute_router_weights(const float* input, float* weights,
-                                   size_t n_experts, size_t d_model) {
+                                   size_t* selected, float* selected_weights,
+                                   size_t n_experts, size_t k_experts,
+                                   size_t d_model) {
     /* Simple router: compute similarity to expert centers */
     for (size_t e = 0; e < n_experts; e++) {
         float score = 0.0f;
+        float expert_center = (float)(e + 1) / (float)(n_experts + 1);
         for (size_t d = 0; d < d_model; d++) {
-            float expert_center = (float)(e + 1) / (float)(n_experts + 1);
             float diff = input[d] - expert_center;
             score -= diff * diff; /* Negative distance */
         }
-        weights[e] = expf(score);
+        weights[e] = score;
     }
     
-    /* Softmax */
+    /* Top-k selection by insertion into a descending list */
+    size_t count = 0;
+    if (k_experts == n_experts) {
+        for (size_t e = 0; e < n_experts; e++) {
+            selected[e] = e;
+        }
+        count = n_experts;
+    }
+    for (size_t e = count; e < n_experts; e++) {
+        if (count == k_experts && weights[e] <= weights[selected[count - 1]]) {
+            continue;
+        }
+        size_t pos = (count < k_experts) ? count++ : count - 1;
+        while (pos > 0 && weights[selected[pos - 1]] < weights[e]) {
+            selected[pos] = selected[pos - 1];
+            pos--;
+        }
+        selected[pos] = e;
+    }
+    
+    /* Softmax over the selected experts */
+    float max_score = weights[selected[0]];
+    for (size_t s = 1; s < k_experts; s++) {
+        max_score = DDAF_MAX(max_score, weights[selected[s]]);
+    }
     float sum = 0.0f;
-    for (size_t e = 0; e < n_experts; e++) {
-        sum += weights[e];
+    for (size_t s = 0; s < k_experts; s++) {
+        selected_weights[s] = expf(weights[selected[s]] - max_score);
+        sum += selected_weights[s];
     }
-    for (size_t e = 0; e < n_experts; e++) {
-        weights[e] /= sum;
+    
+    memset(weights, 0, n_experts * sizeof(float));
+    for (size_t s = 0; s < k_experts; s++) {
+        selected_weights[s] /= sum;
+        weights[selected[s]] = selected_weights[s];
+    }
+}
+
+/* Experts run concurrently only with a pool and enough work to share */
+static bool moe_concurrent(size_t n_tasks, size_t elements) {
+    return ddaf_get_num_threads() > 1 && n_tasks > 1 &&
+           elements > DDAF_PARALLEL_GRAIN;
+}
+
+/* One arena of bytes per pool worker, taken from ctx's pool; NULL if full */
+static moe_arena_t* moe_arenas(ddaf_context_t* ctx, size_t bytes) {
+    size_t n_workers = ddaf_get_num_threads();
+    moe_arena_t* arenas = (moe_arena_t*)ddaf_pool_alloc(ctx->pool,
+                                                         n_workers * sizeof(moe_arena_t));
+    if (!arenas) return NULL;
+    
+    for (size_t w = 0; w < n_workers; w++) {
+        void* buffer = bytes ? ddaf_pool_alloc(ctx->pool, bytes) : NULL;
+        if (bytes && !buffer) return NULL;
+        
+        memset(&arenas[w].pool, 0, sizeof(arenas[w].pool));
+        arenas[w].pool.alignment = ctx->pool->alignment;
+        ddaf_pool_bind(&arenas[w].pool, buffer, bytes, &arenas[w].binding);
     }
+    return arenas;
+}
+
+/*
+ * Forward or backward of one expert on the calling worker's arena. Inputs
+ * were saved beforehand, in call order, by the thread that owns the tree.
+ */
+static int expert_pass(ddaf_context_t* expert, moe_arena_t* arenas,
+                       bool backward, const float* input, float* output,
+                       size_t size) {
+    ddaf_memory_pool_t* arena = &arenas[ddaf_worker_index()].pool;
+    ddaf_memory_pool_t* shared = expert->pool;
     
-    /* Top-k selection */
-    /* Sort and keep top k (simplified - just use top k by value) */
+    expert->pool = arena;
+    expert->batch = 1;
+    size_t mark = ddaf_pool_mark(arena);
+    int ret = backward ? expert->backward(expert, input, output, size)
+                       : expert->forward(expert, input, output, size);
+    ddaf_pool_release(arena, mark);
+    expert->pool = shared;
+    
+    return ret;
+}
+
+static void forward_task(void* arg, size_t begin, size_t end) {
+    moe_tasks_t* tasks = (moe_tasks_t*)arg;
+    moe_params_t* params = tasks->params;
+    
+    for (size_t s = begin; s < end; s++) {
+        ddaf_context_t* expert = params->expert_activations[params->selected[s]];
+        tasks->status[s] = expert_pass(expert, tasks->arenas, false,
+                                       tasks->input,
+                                       params->expert_outputs + s * params->d_model,
+                                       params->d_model);
+    }
+}
+
+/* Each slot scales, then backpropagates, its own gradient row */
+static void backward_task(void* arg, size_t begin, size_t end) {
+    moe_tasks_t* tasks = (moe_tasks_t*)arg;
+    moe_params_t* params = tasks->params;
+    size_t d_model = params->d_model;
+    
+    for (size_t s = begin; s < end; s++) {
+        ddaf_context_t* expert = params->expert_activations[params->selected[s]];
+        float weight = params->selected_weights[s];
+        float* row = tasks->output + s * d_model;
+        
+        for (size_t d = 0; d < d_model; d++) {
+            row[d] = weight * tasks->input[d];
+        }
+        tasks->status[s] = expert_pass(expert, tasks->arenas, true, row, row,
+                                       d_model);
+    }
+}
+
+static void batch_task(void* arg, size_t begin, size_t end) {
+    moe_tasks_t* tasks = (moe_tasks_t*)arg;
+    moe_params_t* params = tasks->params;
+    size_t d_model = params->d_model;
+    
+    for (size_t e = begin; e < end; e++) {
+        const float* input = tasks->input + tasks->rows[e] * d_model;
+        float* output = tasks->output + tasks->rows[e] * d_model;
+        
+        /*
+         * One token at a time: what the serial path's per-sample batched
+         * call computes, without batch scratch the arena was not sized for
+         */
+        tasks->status[e] = 0;
+        for (size_t r = 0; r < tasks->counts[e] && tasks->status[e] == 0;
+             r++) {
+            tasks->status[e] = expert_pass(params->expert_activations[e],
+                                           tasks->arenas, false,
+                                           input + r * d_model,
+                                           output + r * d_model, d_model);
+        }
+    }
+}
+
+/* First failure among n task results */
+static int tasks_status(const int* status, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (status[i] != 0) return status[i];
+    }
+    return 0;
+}
+
+/*
+ * Selected experts of one token on the thread pool. Returns 1, with the
+ * scratch released, when the pool cannot hold the per-worker arenas.
+ */
+static int moe_forward_concurrent(ddaf_context_t* ctx, const float* input) {
+    moe_params_t* params = (moe_params_t*)ctx->params;
+    size_t k = params->k_experts;
+    size_t arena_bytes = 0;
+    for (size_t s = 0; s < k; s++) {
+        arena_bytes = DDAF_MAX(arena_bytes, ddaf_child_forward_workspace(
+            params->expert_activations[params->selected[s]], params->d_model));
+    }
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    moe_tasks_t tasks = { params, moe_arenas(ctx, arena_bytes), input, NULL,
+                          NULL, NULL,
+                          (int*)ddaf_pool_alloc(ctx->pool, k * sizeof(int)) };
+    if (!tasks.arenas || !tasks.status) {
+        ddaf_pool_release(ctx->pool, mark);
+        return 1;
+    }
+    
+    for (size_t s = 0; s < k; s++) {
+        ddaf_save_input(params->expert_activations[params->selected[s]], input,
+                        params->d_model);
+    }
+    ddaf_parallel_for(k, 1, forward_task, &tasks);
+    
+    int ret = tasks_status(tasks.status, k);
+    ddaf_pool_release(ctx->pool, mark);
+    return ret;
 }
 
 static int moe_forward(ddaf_context_t* ctx, const float* input,
@@ -53,26 +252,29 @@ static int moe_forward(ddaf_context_t* ctx, const float* input,
     if (size < params->d_model) return -1;
     
     /* Compute router weights */
-    compute_router_weights(input, params->router_weights, 
-                          params->n_experts, params->d_model);
-    
-    /* Apply each expert */
-    memset(params->expert_outputs, 0, params->d_model * params->n_experts * sizeof(float));
+    compute_router_weights(input, params->router_weights, params->selected,
+                          params->selected_weights, params->n_experts,
+                          params->k_experts, params->d_model);
     
-    for (size_t e = 0; e < params->n_experts; e++) {
-        if (!params->expert_activations[e]) continue;
+    /* Apply only the selected experts, concurrently when worthwhile */
+    int ret = 1;
+    if (moe_concurrent(params->k_experts, params->k_experts * params->d_model)) {
+        ret = moe_forward_concurrent(ctx, input);
+        if (ret < 0) return ret;
+    }
+    for (size_t s = 0; s < params->k_experts && ret > 0; s++) {
+        ddaf_context_t* expert = params->expert_activations[params->selected[s]];
+        float* expert_out = params->expert_outputs + s * params->d_model;
         
-        float* expert_out = params->expert_outputs + e * params->d_model;
-        int ret = ddaf_forward(params->expert_activations[e], input, 
-                              expert_out, params->d_model);
-        if (ret != 0) return ret;
+        int status = ddaf_forward(expert, input, expert_out, params->d_model);
+        if (status != 0) return status;
     }
     
     /* Weighted combination of expert outputs */
     memset(output, 0, params->d_model * sizeof(float));
-    for (size_t e = 0; e < params->n_experts; e++) {
-        float weight = params->router_weights[e];
-        float* expert_out = params->expert_outputs + e * params->d_model;
+    for (size_t s = 0; s < params->k_experts; s++) {
+        float weight = params->selected_weights[s];
+        float* expert_out = params->expert_outputs + s * params->d_model;
         
         for (size_t d = 0; d < params->d_model; d++) {
             output[d] += weight * expert_out[d];
@@ -82,6 +284,61 @@ static int moe_forward(ddaf_context_t* ctx, const float* input,
     return 0;
 }
 
+/*
+ * Selected experts' backward on the thread pool. Each slot fills its own
+ * gradient row and the rows are summed in slot order, as the serial loop
+ * accumulates them. Experts that recompute their input get the MoE input
+ * rebuilt once here, not from every worker. Returns 1 as above.
+ */
+static int moe_backward_concurrent(ddaf_context_t* ctx, const float* grad_output,
+                                   float* grad_input) {
+    moe_params_t* params = (moe_params_t*)ctx->params;
+    size_t d_model = params->d_model;
+    size_t k = params->k_experts;
+    size_t arena_bytes = 0;
+    bool recompute = false;
+    for (size_t s = 0; s < k; s++) {
+        ddaf_context_t* expert = params->expert_activations[params->selected[s]];
+        arena_bytes = DDAF_MAX(arena_bytes,
+                               ddaf_child_backward_workspace(expert, d_model));
+        recompute |= expert->saved_as == DDAF_SAVE_RECOMPUTE;
+    }
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    moe_tasks_t tasks = { params, moe_arenas(ctx, arena_bytes), grad_output,
+                          (float*)ddaf_pool_alloc(ctx->pool, k * d_model *
+                                                  sizeof(float)),
+                          NULL, NULL,
+                          (int*)ddaf_pool_alloc(ctx->pool, k * sizeof(int)) };
+    if (!tasks.arenas || !tasks.output || !tasks.status) {
+        ddaf_pool_release(ctx->pool, mark);
+        return 1;
+    }
+    
+    params->rebuilt = recompute ? ddaf_saved_input(ctx, d_model) : NULL;
+    if (recompute && !params->rebuilt) {
+        ddaf_pool_release(ctx->pool, mark);
+        return 1;
+    }
+    ddaf_parallel_for(k, 1, backward_task, &tasks);
+    params->rebuilt = NULL;
+    
+    int ret = tasks_status(tasks.status, k);
+    if (ret == 0) {
+        /* grad_input may alias grad_output; every row has been scaled */
+        memset(grad_input, 0, d_model * sizeof(float));
+        for (size_t s = 0; s < k; s++) {
+            const float* row = tasks.output + s * d_model;
+            for (size_t d = 0; d < d_model; d++) {
+                grad_input[d] += row[d];
+            }
+        }
+    }
+    
+    ddaf_pool_release(ctx->pool, mark);
+    return ret;
+}
+
 static int moe_backward(ddaf_context_t* ctx, const float* grad_output,
                         float* grad_input, size_t size) {
     moe_params_t* params = (moe_params_t*)ctx->params;
@@ -89,55 +346,328 @@ static int moe_backward(ddaf_context_t* ctx, const float* grad_output,
     
     if (size < params->d_model) return -1;
     
-    /* Backward through experts */
-    float* grad_temp = (float*)ddaf_pool_alloc(ctx->pool, params->d_model * sizeof(float));
+    /*
+     * Backward through the experts selected by the last forward pass.
+     * grad_input may alias grad_output, so it is only written after the
+     * last expert has read grad_output.
+     */
+    size_t d_model = params->d_model;
+    if (moe_concurrent(params->k_experts, params->k_experts * d_model)) {
+        int ret = moe_backward_concurrent(ctx, grad_output, grad_input);
+        if (ret <= 0) return ret;
+    }
+    
+    float* grad_temp = (float*)ddaf_pool_alloc(ctx->pool, d_model * sizeof(float));
     if (!grad_temp) return -1;
     
-    memset(grad_input, 0, params->d_model * sizeof(float));
+    float* grad_sum = (float*)ddaf_pool_alloc(ctx->pool, d_model * sizeof(float));
+    if (!grad_sum) return -1;
     
-    for (size_t e = 0; e < params->n_experts; e++) {
-        if (!params->expert_activations[e]) continue;
-        
-        float weight = params->router_weights[e];
+    memset(grad_sum, 0, d_model * sizeof(float));
+    
+    for (size_t s = 0; s < params->k_experts; s++) {
+        ddaf_context_t* expert = params->expert_activations[params->selected[s]];
+        float weight = params->selected_weights[s];
         
         /* Scale gradient by router weight */
-        for (size_t d = 0; d < params->d_model; d++) {
+        for (size_t d = 0; d < d_model; d++) {
             grad_temp[d] = weight * grad_output[d];
         }
         
-        float* expert_grad = (float*)ddaf_pool_alloc(ctx->pool, 
-                                                    params->d_model * sizeof(float));
-        if (!expert_grad) return -1;
-        
-        int ret = ddaf_backward(params->expert_activations[e], grad_temp, 
-                               expert_grad, params->d_model);
+        int ret = ddaf_backward(expert, grad_temp, grad_temp, d_model);
         if (ret != 0) return ret;
         
         /* Accumulate gradients */
-        for (size_t d = 0; d < params->d_model; d++) {
-            grad_input[d] += expert_grad[d];
+        for (size_t d = 0; d < d_model; d++) {
+            grad_sum[d] += grad_temp[d];
         }
     }
     
+    memcpy(grad_input, grad_sum, d_model * sizeof(float));
+    
     return 0;
 }
 
+/* Capacity of each expert bucket for a batch of n_tokens */
+static size_t moe_capacity(const moe_params_t* params, size_t n_tokens) {
+    size_t assignments = n_tokens * params->k_experts;
+    if (params->capacity_factor <= 0.0f) return assignments;
+    
+    double capacity = ceil((double)params->capacity_factor *
+                           (double)assignments / (double)params->n_experts);
+    return DDAF_MIN((size_t)capacity, assignments);
+}
+
+/*
+ * Batched experts on the thread pool: every bucket is gathered up front,
+ * the experts run as tasks, and the results are scattered in expert order
+ * as the serial loop does. Returns 1 as above.
+ */
+static int moe_batch_concurrent(ddaf_context_t* ctx, const float* input,
+                                float* output, const size_t* bucket_tokens,
+                                const float* bucket_weights,
+                                const size_t* bucket_offset,
+                                const size_t* bucket_count, size_t n_tokens) {
+    moe_params_t* params = (moe_params_t*)ctx->params;
+    size_t d_model = params->d_model;
+    size_t n_experts = params->n_experts;
+    size_t rows = bucket_offset[n_experts - 1] + bucket_count[n_experts - 1];
+    size_t arena_bytes = 0;
+    for (size_t e = 0; e < n_experts; e++) {
+        arena_bytes = DDAF_MAX(arena_bytes, ddaf_child_forward_workspace(
+            params->expert_activations[e], d_model));
+    }
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    float* gathered = (float*)ddaf_pool_alloc(ctx->pool,
+                                              2 * rows * d_model * sizeof(float));
+    moe_tasks_t tasks = { params, moe_arenas(ctx, arena_bytes), gathered,
+                          gathered ? gathered + rows * d_model : NULL,
+                          bucket_offset, bucket_count,
+                          (int*)ddaf_pool_alloc(ctx->pool, n_experts * sizeof(int)) };
+    if (!gathered || !tasks.arenas || !tasks.status) {
+        ddaf_pool_release(ctx->pool, mark);
+        return 1;
+    }
+    
+    for (size_t r = 0; r < rows; r++) {
+        memcpy(gathered + r * d_model, input + bucket_tokens[r] * d_model,
+               d_model * sizeof(float));
+    }
+    for (size_t e = 0; e < n_experts; e++) {
+        if (bucket_count[e] == 0) continue;
+        ddaf_save_input(params->expert_activations[e],
+                        gathered + bucket_offset[e] * d_model,
+                        bucket_count[e] * d_model);
+    }
+    
+    ddaf_parallel_for(n_experts, 1, batch_task, &tasks);
+    
+    int ret = tasks_status(tasks.status, n_experts);
+    if (ret == 0) {
+        /* Scatter back with the router weights */
+        memset(output, 0, n_tokens * d_model * sizeof(float));
+        for (size_t r = 0; r < rows; r++) {
+            float* out = output + bucket_tokens[r] * d_model;
+            const float* row = tasks.output + r * d_model;
+            for (size_t d = 0; d < d_model; d++) {
+                out[d] += bucket_weights[r] * row[d];
+            }
+        }
+    }
+    
+    ddaf_pool_release(ctx->pool, mark);
+    return ret;
+}
+
+int ddaf_moe_forward_batch(ddaf_context_t* ctx, const float* input,
+                           float* output, size_t n_tokens) {
+    if (!ctx || !input || !output || n_tokens == 0) return -1;
+    if (ctx->forward != moe_forward) return -1;
+    
+    moe_params_t* params = (moe_params_t*)ctx->params;
+    if (!params || !params->expert_activations) return -1;
+    
+    size_t d_model = params->d_model;
+    size_t n_experts = params->n_experts;
+    size_t k = params->k_experts;
+    size_t assignments = n_tokens * k;
+    size_t capacity = moe_capacity(params, n_tokens);
+    
+    /* Experts see gathered tokens, not a saved input they could rebuild */
+    ddaf_discard_saved(ctx);
+    
+    /* Routing and bucket bookkeeping, scoped to this call */
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    size_t index_count = 2 * assignments + 2 * n_experts;
+    void* routing = ddaf_pool_alloc(ctx->pool, index_count * sizeof(size_t) +
+                                    2 * assignments * sizeof(float));
+    if (!routing) return -1;
+    
+    size_t* token_experts = (size_t*)routing;          /* [token][slot] */
+    size_t* bucket_tokens = token_experts + assignments;
+    size_t* bucket_count = bucket_tokens + assignments;
+    size_t* bucket_offset = bucket_count + n_experts;
+    float* token_weights = (float*)(bucket_offset + n_experts);
+    float* bucket_weights = token_weights + assignments;
+    
+    for (size_t t = 0; t < n_tokens; t++) {
+        compute_router_weights(input + t * d_model, params->router_weights,
+                              token_experts + t * k, token_weights + t * k,
+                              n_experts, k, d_model);
+    }
+    
+    /*
+     * Count buckets slot-major so every token's first choice claims
+     * capacity before any second choice; assignments beyond it are dropped.
+     */
+    memset(bucket_count, 0, n_experts * sizeof(size_t));
+    for (size_t s = 0; s < k; s++) {
+        for (size_t t = 0; t < n_tokens; t++) {
+            size_t e = token_experts[t * k + s];
+            if (bucket_count[e] < capacity) {
+                bucket_count[e]++;
+            } else {
+                token_experts[t * k + s] = n_experts; /* dropped */
+            }
+        }
+    }
+    
+    size_t largest = 0;
+    size_t offset = 0;
+    for (size_t e = 0; e < n_experts; e++) {
+        bucket_offset[e] = offset;
+        offset += bucket_count[e];
+        largest = DDAF_MAX(largest, bucket_count[e]);
+        bucket_count[e] = 0;
+    }
+    
+    /* Each bucket lists its tokens in order, as a per-token loop visits them */
+    for (size_t t = 0; t < n_tokens; t++) {
+        for (size_t s = 0; s < k; s++) {
+            size_t e = token_experts[t * k + s];
+            if (e == n_experts) continue;
+            
+            size_t slot = bucket_offset[e] + bucket_count[e]++;
+            bucket_tokens[slot] = t;
+            bucket_weights[slot] = token_weights[t * k + s];
+        }
+    }
+    
+    /* Each expert runs once over its gathered bucket, a token per sample */
+    size_t active = 0;
+    for (size_t e = 0; e < n_experts; e++) {
+        active += bucket_count[e] > 0;
+    }
+    if (moe_concurrent(active, offset * d_model)) {
+        int ret = moe_batch_concurrent(ctx, input, output, bucket_tokens,
+                                       bucket_weights, bucket_offset,
+                                       bucket_count, n_tokens);
+        if (ret <= 0) {
+            ddaf_pool_release(ctx->pool, mark);
+            return ret;
+        }
+    }
+    
+    float* gathered = (float*)ddaf_pool_alloc(ctx->pool,
+                                              2 * largest * d_model * sizeof(float));
+    if (!gathered && largest > 0) {
+        ddaf_pool_release(ctx->pool, mark);
+        return -1;
+    }
+    float* expert_out = gathered + largest * d_model;
+    
+    memset(output, 0, n_tokens * d_model * sizeof(float));
+    
+    int ret = 0;
+    for (size_t e = 0; e < n_experts && ret == 0; e++) {
+        size_t count = bucket_count[e];
+        if (count == 0) continue;
+        
+        const size_t* tokens = bucket_tokens + bucket_offset[e];
+        const float* weights = bucket_weights + bucket_offset[e];
+        
+        for (size_t r = 0; r < count; r++) {
+            memcpy(gathered + r * d_model, input + tokens[r] * d_model,
+                   d_model * sizeof(float));
+        }
+        
+        ret = ddaf_forward_batched(params->expert_activations[e], gathered,
+                                   expert_out, count, d_model,
+                                   DDAF_BATCH_PER_SAMPLE);
+        if (ret != 0) break;
+        
+        /* Scatter back with the router weights */
+        for (size_t r = 0; r < count; r++) {
+            float* out = output + tokens[r] * d_model;
+            const float* row = expert_out + r * d_model;
+            for (size_t d = 0; d < d_model; d++) {
+                out[d] += weights[r] * row[d];
+            }
+        }
+    }
+    
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+int ddaf_moe_set_capacity_factor(ddaf_context_t* ctx, float capacity_factor) {
+    if (!ctx || ctx->forward != moe_forward || !ctx->params) return -1;
+    
+    moe_params_t* params = (moe_params_t*)ctx->params;
+    params->capacity_factor = capacity_factor;
+    
+    return 0;
+}
+
+/* Passthrough, served from the copy rebuilt before experts went concurrent */
+static int moe_recompute(ddaf_context_t* ctx, const ddaf_context_t* child,
+                         float* input, size_t size) {
+    const moe_params_t* params = (const moe_params_t*)ctx->params;
+    if (!params->rebuilt) {
+        return ddaf_recompute_passthrough(ctx, child, input, size);
+    }
+    
+    memcpy(input, params->rebuilt, size * sizeof(float));
+    return 0;
+}
+
+/* Any expert may be selected, so take the largest requirement */
+static size_t moe_forward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const moe_params_t* params = (const moe_params_t*)ctx->params;
+    size_t experts = 0;
+    (void)size;
+    for (size_t e = 0; e < params->n_experts; e++) {
+        experts = DDAF_MAX(experts, ddaf_child_forward_workspace(
+            params->expert_activations[e], params->d_model));
+    }
+    return experts;
+}
+
+static size_t moe_backward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const moe_params_t* params = (const moe_params_t*)ctx->params;
+    size_t experts = 0;
+    (void)size;
+    for (size_t e = 0; e < params->n_experts; e++) {
+        experts = DDAF_MAX(experts, ddaf_child_backward_workspace(
+            params->expert_activations[e], params->d_model));
+    }
+    return 2 * ddaf_workspace_floats(ctx, params->d_model) + experts;
+}
+
+static void moe_relocate(ddaf_context_t* ctx,
+                         const ddaf_relocation_t* reloc) {
+    moe_params_t* params = (moe_params_t*)ctx->params;
+    
+    params->expert_activations =
+        ddaf_relocate_ptr(reloc, params->expert_activations);
+    params->selected = ddaf_relocate_ptr(reloc, params->selected);
+    params->router_weights = ddaf_relocate_ptr(reloc, params->router_weights);
+    params->selected_weights =
+        ddaf_relocate_ptr(reloc, params->selected_weights);
+    params->expert_outputs = ddaf_relocate_ptr(reloc, params->expert_outputs);
+    for (size_t i = 0; i < params->n_experts; i++) {
+        params->expert_activations[i] =
+            ddaf_relocate_ptr(reloc, params->expert_activations[i]);
+    }
+}
+
 int ddaf_moe_init(ddaf_context_t* ctx, size_t d_model, size_t n_experts,
                   size_t k_experts) {
     if (!ctx) return -1;
     if (n_experts == 0) return -1;
-    if (k_experts > n_experts) k_experts = n_experts;
+    if (k_experts == 0 || k_experts > n_experts) k_experts = n_experts;
     
     size_t param_size = sizeof(moe_params_t) +
                         n_experts * sizeof(ddaf_context_t*) +
+                        k_experts * sizeof(size_t) + /* selected experts */
                         n_experts * sizeof(float) + /* router weights */
-                        d_model * n_experts * sizeof(float); /* expert outputs */
+                        k_experts * sizeof(float) + /* selected weights */
+                        d_model * k_experts * sizeof(float); /* expert outputs */
     
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     moe_params_t* params = (moe_params_t*)ctx->params;
@@ -147,19 +677,20 @@ int ddaf_moe_init(ddaf_context_t* ctx, size_t d_model, size_t n_experts,
     
     char* ptr = (char*)params + sizeof(moe_params_t);
     params->expert_activations = (ddaf_context_t**)ptr;
-    params->router_weights = (float*)(params->expert_activations + n_experts);
-    params->expert_outputs = params->router_weights + n_experts;
+    params->selected = (size_t*)(params->expert_activations + n_experts);
+    params->router_weights = (float*)(params->selected + k_experts);
+    params->selected_weights = params->router_weights + n_experts;
+    params->expert_outputs = params->selected_weights + k_experts;
     
     /* Initialize expert activations */
     for (size_t e = 0; e < n_experts; e++) {
-        params->expert_activations[e] = ddaf_create_context(ctx->type, ctx->arch, 0);
+        params->expert_activations[e] = ddaf_create_child_context(ctx);
         if (!params->expert_activations[e]) {
             /* Cleanup on failure */
             for (size_t i = 0; i < e; i++) {
                 ddaf_destroy_context(params->expert_activations[i]);
             }
-            free(ctx->params);
-            ctx->params = NULL;
+            ddaf_free_params(ctx);
             return -1;
         }
         
@@ -181,8 +712,7 @@ int ddaf_moe_init(ddaf_context_t* ctx, size_t d_model, size_t n_experts,
                 for (size_t i = 0; i <= e; i++) {
                     ddaf_destroy_context(params->expert_activations[i]);
                 }
-                free(ctx->params);
-                ctx->params = NULL;
+                ddaf_free_params(ctx);
                 return -1;
         }
     }
@@ -191,9 +721,19 @@ int ddaf_moe_init(ddaf_context_t* ctx, size_t d_model, size_t n_experts,
     for (size_t e = 0; e < n_experts; e++) {
         params->router_weights[e] = 1.0f / n_experts;
     }
+    for (size_t s = 0; s < k_experts; s++) {
+        params->selected[s] = s;
+        params->selected_weights[s] = 1.0f / k_experts;
+    }
     
     ctx->forward = moe_forward;
     ctx->backward = moe_backward;
+    ctx->forward_batched = NULL;    /* Routed one token at a time */
+    ctx->backward_batched = NULL;
+    ctx->relocate = moe_relocate;
+    ctx->forward_workspace = moe_forward_workspace;
+    ctx->backward_workspace = moe_backward_workspace;
+    ctx->recompute = moe_recompute;
     
     return 0;
 }
@@ -22,15 +22,16 @@ static int rnn_forward(ddaf_context_t* ctx, const float* input,
     rnn_params_t* params = (rnn_params_t*)ctx->params;
     if (!params || !params->activation_ctx) return -1;
     
-    /* Combine input with hidden state for RNN */
-    float* combined = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-    if (!combined) return -1;
-    
-    for (size_t i = 0; i < size && i < params->hidden_size; i++) {
-        combined[i] = input[i] + (params->hidden_state ? params->hidden_state[i] : 0.0f);
+    /* Combine input with hidden state in output, then activate in place */
+    size_t hidden = DDAF_MIN(size, params->hidden_size);
+    for (size_t i = 0; i < hidden; i++) {
+        output[i] = input[i] + (params->hidden_state ? params->hidden_state[i] : 0.0f);
+    }
+    if (output != input) {
+        memcpy(output + hidden, input + hidden, (size - hidden) * sizeof(float));
     }
     
-    int ret = ddaf_forward(params->activation_ctx, combined, output, size);
+    int ret = ddaf_forward(params->activation_ctx, output, output, size);
     
     /* Update hidden state */
     if (params->hidden_state && size <= params->hidden_size) {
@@ -40,23 +41,79 @@ static int rnn_forward(ddaf_context_t* ctx, const float* input,
     return ret;
 }
 
+/* Each sample combines with its own hidden state; one activation call */
+static int rnn_forward_batched(ddaf_context_t* ctx, const float* input,
+                               float* output, size_t batch, size_t sample_size,
+                               unsigned flags) {
+    (void)flags;
+    rnn_params_t* params = (rnn_params_t*)ctx->params;
+    if (!params || !params->activation_ctx) return -1;
+    
+    float* state = ddaf_batch_state(ctx, params->hidden_size,
+                                    params->hidden_state);
+    if (!state) return -1;
+    
+    size_t hidden = DDAF_MIN(sample_size, params->hidden_size);
+    for (size_t b = 0; b < batch; b++) {
+        const float* in = input + b * sample_size;
+        float* out = output + b * sample_size;
+        const float* hidden_state = state + b * params->hidden_size;
+        
+        for (size_t i = 0; i < hidden; i++) {
+            out[i] = in[i] + hidden_state[i];
+        }
+        if (out != in) {
+            memcpy(out + hidden, in + hidden,
+                   (sample_size - hidden) * sizeof(float));
+        }
+    }
+    
+    int ret = ddaf_child_forward(ctx, params->activation_ctx, output, output,
+                                 batch * sample_size);
+    
+    if (sample_size <= params->hidden_size) {
+        for (size_t b = 0; b < batch; b++) {
+            memcpy(state + b * params->hidden_size, output + b * sample_size,
+                   sample_size * sizeof(float));
+        }
+    }
+    
+    return ret;
+}
+
 static int rnn_backward(ddaf_context_t* ctx, const float* grad_output,
                         float* grad_input, size_t size) {
     rnn_params_t* params = (rnn_params_t*)ctx->params;
     if (!params || !params->activation_ctx) return -1;
     
-    return ddaf_backward(params->activation_ctx, grad_output, grad_input, size);
+    return ddaf_child_backward(ctx, params->activation_ctx, grad_output,
+                               grad_input, size);
+}
+
+static size_t rnn_forward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const rnn_params_t* params = (const rnn_params_t*)ctx->params;
+    return ddaf_child_forward_workspace(params->activation_ctx, size);
+}
+
+static size_t rnn_backward_workspace(const ddaf_context_t* ctx, size_t size) {
+    const rnn_params_t* params = (const rnn_params_t*)ctx->params;
+    return ddaf_child_backward_workspace(params->activation_ctx, size);
+}
+
+static void rnn_relocate(ddaf_context_t* ctx,
+                         const ddaf_relocation_t* reloc) {
+    rnn_params_t* params = (rnn_params_t*)ctx->params;
+    
+    params->hidden_state = ddaf_relocate_ptr(reloc, params->hidden_state);
+    params->activation_ctx = ddaf_relocate_ptr(reloc, params->activation_ctx);
 }
 
 int ddaf_rnn_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
     if (!ctx) return -1;
     
     size_t param_size = sizeof(rnn_params_t) + hidden_size * sizeof(float);
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     rnn_params_t* params = (rnn_params_t*)ctx->params;
@@ -68,10 +125,9 @@ int ddaf_rnn_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
     memset(params->hidden_state, 0, hidden_size * sizeof(float));
     
     /* Create activation context */
-    params->activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->activation_ctx = ddaf_create_child_context(ctx);
     if (!params->activation_ctx) {
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
@@ -90,14 +146,18 @@ int ddaf_rnn_init(ddaf_context_t* ctx, size_t hidden_size, size_t seq_len) {
             ddaf_init_attention(params->activation_ctx, hidden_size, 4, seq_len);
             break;
         default:
-            free(ctx->params);
-            ctx->params = NULL;
             ddaf_destroy_context(params->activation_ctx);
+            ddaf_free_params(ctx);
             return -1;
     }
     
     ctx->forward = rnn_forward;
     ctx->backward = rnn_backward;
+    ctx->forward_batched = rnn_forward_batched;
+    ctx->backward_batched = ddaf_batch_backward_flat;
+    ctx->relocate = rnn_relocate;
+    ctx->forward_workspace = rnn_forward_workspace;
+    ctx->backward_workspace = rnn_backward_workspace;
     
     return 0;
 }
@@ -24,7 +24,7 @@ static int transformer_forward(ddaf_context_t* ctx, const float* input,
     if (!params || !params->activation_ctx) return -1;
     
     /* Apply activation in transformer blocks */
-    return ddaf_forward(params->activation_ctx, input, output, size);
+    return ddaf_child_forward(ctx, params->activation_ctx, input, output, size);
 }
 
 static int transformer_backward(ddaf_context_t* ctx, const float* grad_output,
@@ -32,7 +32,31 @@ static int transformer_backward(ddaf_context_t* ctx, const float* grad_output,
     transformer_params_t* params = (transformer_params_t*)ctx->params;
     if (!params || !params->activation_ctx) return -1;
     
-    return ddaf_backward(params->activation_ctx, grad_output, grad_input, size);
+    return ddaf_child_backward(ctx, params->activation_ctx, grad_output,
+                               grad_input, size);
+}
+
+static size_t transformer_forward_workspace(const ddaf_context_t* ctx,
+                                            size_t size) {
+    const transformer_params_t* params =
+        (const transformer_params_t*)ctx->params;
+    return ddaf_child_forward_workspace(params->activation_ctx, size);
+}
+
+static size_t transformer_backward_workspace(const ddaf_context_t* ctx,
+                                             size_t size) {
+    const transformer_params_t* params =
+        (const transformer_params_t*)ctx->params;
+    return ddaf_child_backward_workspace(params->activation_ctx, size);
+}
+
+static void transformer_relocate(ddaf_context_t* ctx,
+                                 const ddaf_relocation_t* reloc) {
+    transformer_params_t* params = (transformer_params_t*)ctx->params;
+    
+    params->activation_ctx = ddaf_relocate_ptr(reloc, params->activation_ctx);
+    params->ffn_activation_ctx =
+        ddaf_relocate_ptr(reloc, params->ffn_activation_ctx);
 }
 
 int ddaf_transformer_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
@@ -41,11 +65,8 @@ int ddaf_transformer_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
     if (d_model % n_heads != 0) return -1;
     
     size_t param_size = sizeof(transformer_params_t);
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_destroy_children(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     transformer_params_t* params = (transformer_params_t*)ctx->params;
@@ -54,18 +75,16 @@ int ddaf_transformer_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
     params->seq_len = seq_len;
     
     /* Create activation contexts */
-    params->activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->activation_ctx = ddaf_create_child_context(ctx);
     if (!params->activation_ctx) {
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
-    params->ffn_activation_ctx = ddaf_create_context(ctx->type, ctx->arch, 0);
+    params->ffn_activation_ctx = ddaf_create_child_context(ctx);
     if (!params->ffn_activation_ctx) {
         ddaf_destroy_context(params->activation_ctx);
-        free(ctx->params);
-        ctx->params = NULL;
+        ddaf_free_params(ctx);
         return -1;
     }
     
@@ -90,13 +109,18 @@ int ddaf_transformer_init(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
         default:
             ddaf_destroy_context(params->ffn_activation_ctx);
             ddaf_destroy_context(params->activation_ctx);
-            free(ctx->params);
-            ctx->params = NULL;
+            ddaf_free_params(ctx);
             return -1;
     }
     
     ctx->forward = transformer_forward;
     ctx->backward = transformer_backward;
+    ctx->relocate = transformer_relocate;
+    ctx->forward_workspace = transformer_forward_workspace;
+    ctx->backward_workspace = transformer_backward_workspace;
+    ctx->recompute = ddaf_recompute_passthrough;
+    ctx->forward_batched = ddaf_batch_forward_flat;
+    ctx->backward_batched = ddaf_batch_backward_flat;
     
     return 0;
 }
@@ -9,45 +9,225 @@
 #include <stdlib.h>
 #include <string.h>
 
+void ddaf_context_options_init(ddaf_context_options_t* options) {
+    if (!options) return;
+    
+    memset(options, 0, sizeof(ddaf_context_options_t));
+    options->pool_size = DDAF_DEFAULT_POOL_SIZE;
+    options->alignment = DDAF_POOL_ALIGNMENT;
+}
+
 ddaf_context_t* ddaf_create_context(ddaf_type_t type, ddaf_arch_t arch, 
                                      size_t param_size) {
-    ddaf_context_t* ctx = (ddaf_context_t*)calloc(1, sizeof(ddaf_context_t));
+    return ddaf_create_context_ex(type, arch, param_size, NULL);
+}
+
+/* Context without a pool; the caller creates or borrows one */
+static ddaf_context_t* context_alloc(ddaf_type_t type, ddaf_arch_t arch,
+                                     size_t param_size,
+                                     const ddaf_context_options_t* options) {
+    ddaf_context_t* ctx = (ddaf_context_t*)
+        ddaf_allocator_malloc(&options->allocator, sizeof(ddaf_context_t));
     if (!ctx) return NULL;
     
+    memset(ctx, 0, sizeof(ddaf_context_t));
     ctx->type = type;
     ctx->arch = arch;
     ctx->requires_grad = true;
+    ctx->precision = DDAF_PRECISION_EXACT;
+    ctx->batch = 1;
+    ctx->options = *options;
     
     if (param_size > 0) {
-        ctx->params = calloc(1, param_size);
+        ctx->params = ddaf_ctx_alloc(ctx, param_size);
         if (!ctx->params) {
-            free(ctx);
+            ddaf_allocator_free(&options->allocator, ctx);
             return NULL;
         }
+        ctx->params_size = param_size;
+    }
+    
+    return ctx;
+}
+
+ddaf_context_t* ddaf_create_context_ex(ddaf_type_t type, ddaf_arch_t arch,
+                                       size_t param_size,
+                                       const ddaf_context_options_t* options) {
+    ddaf_context_options_t defaults;
+    if (!options) {
+        ddaf_context_options_init(&defaults);
+        options = &defaults;
     }
     
-    ctx->pool = ddaf_create_pool(1024 * 1024); /* 1MB default pool */
+    ddaf_context_t* ctx = context_alloc(type, arch, param_size, options);
+    if (!ctx) return NULL;
+    
+    ctx->pool = ddaf_create_pool_ex(options->pool_size, options->alignment,
+                                    options->pool_flags, &options->allocator);
     if (!ctx->pool) {
-        free(ctx->params);
-        free(ctx);
+        ddaf_ctx_free(ctx, ctx->params);
+        ddaf_allocator_free(&options->allocator, ctx);
         return NULL;
     }
+    ctx->owns_pool = true;
     
     return ctx;
 }
 
+void* ddaf_ctx_alloc(const ddaf_context_t* ctx, size_t size) {
+    void* ptr = ddaf_allocator_malloc(&ctx->options.allocator, size);
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void ddaf_ctx_free(const ddaf_context_t* ctx, void* ptr) {
+    if (ddaf_in_arena(ctx, ptr)) return;
+    ddaf_allocator_free(&ctx->options.allocator, ptr);
+}
+
+bool ddaf_in_arena(const ddaf_context_t* ctx, const void* ptr) {
+    if (!ptr) return false;
+    
+    while (ctx->parent) {
+        ctx = ctx->parent;
+    }
+    if (!ctx->arena) return false;
+    
+    const char* p = (const char*)ptr;
+    const char* base = (const char*)ctx->arena;
+    return p >= base && p < base + ctx->arena_size;
+}
+
+void* ddaf_alloc_params(ddaf_context_t* ctx, size_t size) {
+    const ddaf_allocator_t* allocator = &ctx->options.allocator;
+    void* params = NULL;
+    
+    /* A compacted block cannot be resized; start a separate one */
+    if (ddaf_in_arena(ctx, ctx->params)) {
+        ctx->params = NULL;
+    }
+    
+    if (ctx->params && (allocator->realloc_fn || !allocator->malloc_fn)) {
+        params = allocator->realloc_fn ?
+                 allocator->realloc_fn(ctx->params, size, allocator->user_data) :
+                 realloc(ctx->params, size);
+        if (!params) {
+            ddaf_free_params(ctx);
+            return NULL;
+        }
+        memset(params, 0, size);
+    } else {
+        ddaf_free_params(ctx);
+        params = ddaf_ctx_alloc(ctx, size);
+    }
+    
+    ctx->params = params;
+    ctx->params_size = params ? size : 0;
+    
+    /* New params, new per-sample state and layout */
+    ddaf_ctx_free(ctx, ctx->batch_state);
+    ctx->batch_state = NULL;
+    ctx->batch_state_size = 0;
+    ctx->state_size = NULL;
+    
+    return params;
+}
+
+void ddaf_free_params(ddaf_context_t* ctx) {
+    ddaf_ctx_free(ctx, ctx->params);
+    ctx->params = NULL;
+    ctx->params_size = 0;
+}
+
+ddaf_context_t* ddaf_create_child_context(ddaf_context_t* parent) {
+    if (!parent) return NULL;
+    
+    ddaf_context_t* child = context_alloc(parent->type, parent->arch, 0,
+                                          &parent->options);
+    if (!child) return NULL;
+    
+    /*
+     * The whole tree shares the root's pool. Calls nest strictly inside
+     * their parent's call, so each child's frame sits on top of the
+     * parent's scratch and is popped before the parent continues.
+     */
+    child->pool = parent->pool;
+    child->owns_pool = false;
+    
+    child->requires_grad = parent->requires_grad;
+    child->precision = parent->precision;
+    child->save_policy = parent->save_policy;
+    child->parent = parent;
+    
+    /* Append so traversal follows creation order */
+    ddaf_context_t** link = &parent->first_child;
+    while (*link) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child;
+    
+    return child;
+}
+
+void ddaf_destroy_children(ddaf_context_t* ctx) {
+    if (!ctx) return;
+    
+    while (ctx->first_child) {
+        ddaf_destroy_context(ctx->first_child);
+    }
+}
+
 void ddaf_destroy_context(ddaf_context_t* ctx) {
     if (!ctx) return;
     
-    if (ctx->params) {
-        free(ctx->params);
+    ddaf_destroy_children(ctx);
+    
+    /* Unlink from the parent's child list */
+    if (ctx->parent) {
+        ddaf_context_t** link = &ctx->parent->first_child;
+        while (*link && *link != ctx) {
+            link = &(*link)->next_sibling;
+        }
+        if (*link) {
+            *link = ctx->next_sibling;
+        }
     }
     
-    if (ctx->pool) {
+    ddaf_free_params(ctx);
+    ddaf_ctx_free(ctx, ctx->baked);
+    ddaf_ctx_free(ctx, ctx->saved);
+    ddaf_ctx_free(ctx, ctx->batch_state);
+    
+    if (ctx->pool && ctx->owns_pool) {
         ddaf_destroy_pool(ctx->pool);
     }
     
-    free(ctx);
+    /* Compacted contexts are released with their root's block */
+    bool in_arena = ddaf_in_arena(ctx, ctx);
+    ddaf_allocator_t allocator = ctx->options.allocator;
+    ddaf_allocator_free(&allocator, ctx->arena);
+    if (!in_arena) {
+        ddaf_allocator_free(&allocator, ctx);
+    }
+}
+
+int ddaf_set_precision(ddaf_context_t* ctx, ddaf_precision_t precision) {
+    if (!ctx) return -1;
+    if ((unsigned)precision >= DDAF_PRECISION_COUNT) return -1;
+    
+    ctx->precision = precision;
+    for (ddaf_context_t* child = ctx->first_child; child; 
+         child = child->next_sibling) {
+        ddaf_set_precision(child, precision);
+    }
+    
+    return 0;
+}
+
+ddaf_precision_t ddaf_get_precision(const ddaf_context_t* ctx) {
+    return ctx ? ctx->precision : DDAF_PRECISION_EXACT;
 }
 
 int ddaf_forward(ddaf_context_t* ctx, const float* input, float* output, 
@@ -55,7 +235,16 @@ int ddaf_forward(ddaf_context_t* ctx, const float* input, float* output,
     if (!ctx || !input || !output || size == 0) return -1;
     if (!ctx->forward) return -1;
     
-    return ctx->forward(ctx, input, output, size);
+    /* Kept before the pass, which may overwrite input in place */
+    ddaf_save_input(ctx, input, size);
+    
+    /* Scratch taken from the pool lives for this call only */
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->batch = 1;
+    int ret = ctx->forward(ctx, input, output, size);
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
 }
 
 int ddaf_backward(ddaf_context_t* ctx, const float* grad_output, 
@@ -63,5 +252,249 @@ int ddaf_backward(ddaf_context_t* ctx, const float* grad_output,
     if (!ctx || !grad_output || !grad_input || size == 0) return -1;
     if (!ctx->backward) return -1;
     
-    return ctx->backward(ctx, grad_output, grad_input, size);
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->batch = 1;
+    int ret = ctx->backward(ctx, grad_output, grad_input, size);
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+static bool batch_valid(const ddaf_context_t* ctx, size_t batch,
+                        size_t sample_size, unsigned flags) {
+    if (batch == 0 || sample_size == 0) return false;
+    if (flags & ~(unsigned)DDAF_BATCH_PER_SAMPLE) return false;
+    return ctx && batch <= SIZE_MAX / sample_size;
+}
+
+int ddaf_forward_batched(ddaf_context_t* ctx, const float* input,
+                         float* output, size_t batch, size_t sample_size,
+                         unsigned flags) {
+    if (!batch_valid(ctx, batch, sample_size, flags)) return -1;
+    if (!input || !output || !ctx->forward) return -1;
+    
+    /* No batched path: one call per sample, as a caller's loop would make */
+    if (!ctx->forward_batched) {
+        for (size_t b = 0; b < batch; b++) {
+            size_t offset = b * sample_size;
+            int ret = ddaf_forward(ctx, input + offset, output + offset,
+                                   sample_size);
+            if (ret != 0) return ret;
+        }
+        return 0;
+    }
+    
+    ddaf_save_input(ctx, input, batch * sample_size);
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->batch = batch;
+    ctx->batch_flags = flags;
+    int ret = ctx->forward_batched(ctx, input, output, batch, sample_size,
+                                   flags);
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+int ddaf_backward_batched(ddaf_context_t* ctx, const float* grad_output,
+                          float* grad_input, size_t batch, size_t sample_size,
+                          unsigned flags) {
+    if (!batch_valid(ctx, batch, sample_size, flags)) return -1;
+    if (!grad_output || !grad_input || !ctx->backward) return -1;
+    
+    if (!ctx->backward_batched) {
+        if (batch > 1) return -1;
+        return ddaf_backward(ctx, grad_output, grad_input, sample_size);
+    }
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->batch = batch;
+    ctx->batch_flags = flags;
+    int ret = ctx->backward_batched(ctx, grad_output, grad_input, batch,
+                                    sample_size, flags);
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+int ddaf_child_forward(const ddaf_context_t* parent, ddaf_context_t* child,
+                       const float* input, float* output, size_t size) {
+    if (parent->batch <= 1) return ddaf_forward(child, input, output, size);
+    
+    return ddaf_forward_batched(child, input, output, parent->batch,
+                                size / parent->batch, parent->batch_flags);
+}
+
+int ddaf_child_backward(const ddaf_context_t* parent, ddaf_context_t* child,
+                        const float* grad_output, float* grad_input,
+                        size_t size) {
+    if (parent->batch <= 1) {
+        return ddaf_backward(child, grad_output, grad_input, size);
+    }
+    
+    return ddaf_backward_batched(child, grad_output, grad_input, parent->batch,
+                                 size / parent->batch, parent->batch_flags);
+}
+
+int ddaf_batch_forward_flat(ddaf_context_t* ctx, const float* input,
+                            float* output, size_t batch, size_t sample_size,
+                            unsigned flags) {
+    (void)flags;
+    return ctx->forward(ctx, input, output, batch * sample_size);
+}
+
+int ddaf_batch_backward_flat(ddaf_context_t* ctx, const float* grad_output,
+                             float* grad_input, size_t batch,
+                             size_t sample_size, unsigned flags) {
+    (void)flags;
+    return ctx->backward(ctx, grad_output, grad_input, batch * sample_size);
+}
+
+float* ddaf_batch_state(ddaf_context_t* ctx, size_t per_sample,
+                        const float* initial) {
+    size_t size = ctx->batch * per_sample;
+    if (ctx->batch_state && ctx->batch_state_size == size) {
+        return ctx->batch_state;
+    }
+    
+    ddaf_ctx_free(ctx, ctx->batch_state);
+    ctx->batch_state = (float*)ddaf_ctx_alloc(ctx, size * sizeof(float));
+    ctx->batch_state_size = ctx->batch_state ? size : 0;
+    if (ctx->batch_state && initial) {
+        for (size_t b = 0; b < ctx->batch; b++) {
+            memcpy(ctx->batch_state + b * per_sample, initial,
+                   per_sample * sizeof(float));
+        }
+    }
+    
+    return ctx->batch_state;
+}
+
+/*
+ * 16-bit forward: the type's own path when it has one, otherwise widen into
+ * pool scratch, run the float pass in place and narrow the result
+ */
+static int forward16(ddaf_context_t* ctx, const uint16_t* input,
+                     uint16_t* output, size_t size, ddaf_dtype_t dtype) {
+    if (!ctx || !input || !output || size == 0) return -1;
+    if (!ctx->forward) return -1;
+    
+    ddaf_save_input16(ctx, input, size, dtype);
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->batch = 1;
+    int ret = -1;
+    if (ctx->forward16) {
+        ret = ctx->forward16(ctx, input, output, size, dtype);
+    } else {
+        float* buffer = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
+        if (buffer) {
+            ddaf_widen(dtype, input, buffer, size);
+            ret = ctx->forward(ctx, buffer, buffer, size);
+            if (ret == 0) ddaf_narrow(dtype, buffer, output, size);
+        }
+    }
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+static int backward16(ddaf_context_t* ctx, const uint16_t* grad_output,
+                      uint16_t* grad_input, size_t size, ddaf_dtype_t dtype) {
+    if (!ctx || !grad_output || !grad_input || size == 0) return -1;
+    if (!ctx->backward) return -1;
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->batch = 1;
+    int ret = -1;
+    float* buffer = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
+    if (buffer) {
+        ddaf_widen(dtype, grad_output, buffer, size);
+        ret = ctx->backward(ctx, buffer, buffer, size);
+        if (ret == 0) ddaf_narrow(dtype, buffer, grad_input, size);
+    }
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+int ddaf_forward_f16(ddaf_context_t* ctx, const uint16_t* input,
+                     uint16_t* output, size_t size) {
+    return forward16(ctx, input, output, size, DDAF_DTYPE_F16);
+}
+
+int ddaf_forward_bf16(ddaf_context_t* ctx, const uint16_t* input,
+                      uint16_t* output, size_t size) {
+    return forward16(ctx, input, output, size, DDAF_DTYPE_BF16);
+}
+
+int ddaf_backward_f16(ddaf_context_t* ctx, const uint16_t* grad_output,
+                      uint16_t* grad_input, size_t size) {
+    return backward16(ctx, grad_output, grad_input, size, DDAF_DTYPE_F16);
+}
+
+int ddaf_backward_bf16(ddaf_context_t* ctx, const uint16_t* grad_output,
+                       uint16_t* grad_input, size_t size) {
+    return backward16(ctx, grad_output, grad_input, size, DDAF_DTYPE_BF16);
+}
+
+size_t ddaf_workspace_floats(const ddaf_context_t* ctx, size_t count) {
+    size_t alignment = ctx->pool ? ctx->pool->alignment : DDAF_POOL_ALIGNMENT;
+    size_t bytes = count * sizeof(float);
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+size_t ddaf_child_forward_workspace(const ddaf_context_t* ctx, size_t size) {
+    if (!ctx || !ctx->forward_workspace) return 0;
+    return ctx->forward_workspace(ctx, size);
+}
+
+size_t ddaf_child_backward_workspace(const ddaf_context_t* ctx, size_t size) {
+    if (!ctx || !ctx->backward_workspace) return 0;
+    return ctx->backward_workspace(ctx, size);
+}
+
+/* Room to align an arbitrary workspace pointer to the pool alignment */
+static size_t workspace_slack(const ddaf_context_t* ctx, size_t bytes) {
+    if (bytes == 0) return 0;
+    size_t alignment = ctx->pool ? ctx->pool->alignment : DDAF_POOL_ALIGNMENT;
+    return bytes + alignment - 1;
+}
+
+size_t ddaf_forward_workspace_size(const ddaf_context_t* ctx, size_t size) {
+    if (!ctx) return 0;
+    return workspace_slack(ctx, ddaf_child_forward_workspace(ctx, size));
+}
+
+size_t ddaf_backward_workspace_size(const ddaf_context_t* ctx, size_t size) {
+    if (!ctx) return 0;
+    return workspace_slack(ctx, ddaf_child_backward_workspace(ctx, size));
+}
+
+int ddaf_forward_ws(ddaf_context_t* ctx, const float* input, float* output,
+                    size_t size, void* workspace, size_t workspace_size) {
+    if (!ctx || !ctx->pool) return -1;
+    if (workspace_size < ddaf_forward_workspace_size(ctx, size)) return -1;
+    
+    /* The whole tree shares this pool, so nested calls use workspace too */
+    ddaf_pool_binding_t binding;
+    ddaf_pool_bind(ctx->pool, workspace, workspace_size, &binding);
+    int ret = ddaf_forward(ctx, input, output, size);
+    ddaf_pool_unbind(ctx->pool, &binding);
+    
+    return ret;
+}
+
+int ddaf_backward_ws(ddaf_context_t* ctx, const float* grad_output,
+                     float* grad_input, size_t size, void* workspace,
+                     size_t workspace_size) {
+    if (!ctx || !ctx->pool) return -1;
+    if (workspace_size < ddaf_backward_workspace_size(ctx, size)) return -1;
+    
+    ddaf_pool_binding_t binding;
+    ddaf_pool_bind(ctx->pool, workspace, workspace_size, &binding);
+    int ret = ddaf_backward(ctx, grad_output, grad_input, size);
+    ddaf_pool_unbind(ctx->pool, &binding);
+    
+    return ret;
 }
@@ -0,0 +1,1256 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Vectorized activation kernels with runtime CPU dispatch
+ * Array versions of GELU, Swish, sigmoid and tanh for SSE4.2, AVX2 and
+ * AVX-512, with a scalar fallback selected from CPUID at startup, plus the
+ * fp16/bf16 storage conversions (F16C, AVX-512F, AVX-512-BF16).
+ *
+ * Each ISA provides three accuracy tiers (see ddaf_precision_t):
+ *   EXACT   - degree-6 exp, IEEE division, small-|x| tanh polynomial
+ *   FAST    - degree-3 minimax exp, reciprocal estimate + Newton step
+ *   FASTEST - degree-2 minimax exp, raw reciprocal estimate
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DDAF_X86_DISPATCH 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/* exp(x) range reduction constants (Cephes expf) */
+#define DDAF_EXP_HI      88.0200f
+#define DDAF_EXP_LO     -87.3365f
+#define DDAF_LOG2E       1.44269504088896341f
+#define DDAF_LN2_HI      0.693359375f
+#define DDAF_LN2_LO     -2.12194440e-4f
+#define DDAF_EXP_P0      1.9875691500e-4f
+#define DDAF_EXP_P1      1.3981999507e-3f
+#define DDAF_EXP_P2      8.3334519073e-3f
+#define DDAF_EXP_P3      4.1665795894e-2f
+#define DDAF_EXP_P4      1.6666665459e-1f
+#define DDAF_EXP_P5      5.0000001201e-1f
+
+/* Minimax exp(r) on [-ln2/2, ln2/2], max relative error 7.5e-5 */
+#define DDAF_EXP3_C0     9.9992807354e-01f
+#define DDAF_EXP3_C1     1.0001641858e+00f
+#define DDAF_EXP3_C2     5.0496326418e-01f
+#define DDAF_EXP3_C3     1.6566842348e-01f
+
+/* Minimax exp(r) on [-ln2/2, ln2/2], max relative error 1.7e-3 */
+#define DDAF_EXP2_C0     1.0004431419e+00f
+#define DDAF_EXP2_C1     1.0148609496e+00f
+#define DDAF_EXP2_C2     4.9625859117e-01f
+
+/* tanh(x) small-argument polynomial (Cephes tanhf), used for |x| < 0.625 */
+#define DDAF_TANH_SMALL  0.625f
+#define DDAF_TANH_P0    -5.70498872745e-3f
+#define DDAF_TANH_P1     2.06390887954e-2f
+#define DDAF_TANH_P2    -5.37397155531e-2f
+#define DDAF_TANH_P3     1.33314422036e-1f
+#define DDAF_TANH_P4    -3.33332819422e-1f
+
+/* GELU tanh-approximation constants: gelu(x) = x * sigmoid(2 * u(x)) */
+#define DDAF_GELU_K0     1.59576912160573f  /* 2 * sqrt(2 / pi) */
+#define DDAF_GELU_K1     0.044715f
+
+/* ------------------------------------------------------------------ */
+/* Scalar fallback                                                    */
+/* ------------------------------------------------------------------ */
+
+static void gelu_scalar(const float* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_gelu(input[i]);
+    }
+}
+
+static void swish_scalar(const float* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_swish(input[i]);
+    }
+}
+
+static void sigmoid_scalar(const float* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_sigmoid(input[i]);
+    }
+}
+
+static void tanh_scalar(const float* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_tanh(input[i]);
+    }
+}
+
+static void exp_array_scalar(const float* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = expf(input[i]);
+    }
+}
+
+static void lut_scalar(const ddaf_lut_t* lut, const float* input, float* output,
+                       size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_lut_eval(lut, input[i]);
+    }
+}
+
+/* 2^n * p for integral n in [-126, 127] */
+static inline float scale_pow2_scalar(float p, float n) {
+    union { float f; int32_t i; } bits;
+    bits.i = ((int32_t)n + 127) << 23;
+    return p * bits.f;
+}
+
+static inline float exp_fast_scalar(float x) {
+    x = DDAF_MIN(DDAF_EXP_HI, DDAF_MAX(DDAF_EXP_LO, x));
+    float n = nearbyintf(x * DDAF_LOG2E);
+    float r = x - n * DDAF_LN2_HI - n * DDAF_LN2_LO;
+    float p = DDAF_EXP3_C0 + r * (DDAF_EXP3_C1 + r * (DDAF_EXP3_C2 + r * DDAF_EXP3_C3));
+    return scale_pow2_scalar(p, n);
+}
+
+static inline float exp_fastest_scalar(float x) {
+    x = DDAF_MIN(DDAF_EXP_HI, DDAF_MAX(DDAF_EXP_LO, x));
+    float n = nearbyintf(x * DDAF_LOG2E);
+    float r = x - n * DDAF_LN2_HI;
+    float p = DDAF_EXP2_C0 + r * (DDAF_EXP2_C1 + r * DDAF_EXP2_C2);
+    return scale_pow2_scalar(p, n);
+}
+
+/*
+ * Approximate tiers in scalar form. These are the reference behaviour of
+ * FAST/FASTEST on every ISA and also handle the vector loop tails.
+ */
+#define DDAF_SCALAR_TIER_KERNELS(tier, exp_fn)                                \
+static inline float sigmoid_##tier(float z) {                                 \
+    return 1.0f / (1.0f + exp_fn(-z));                                        \
+}                                                                             \
+static void gelu_scalar_##tier(const float* input, float* output, size_t n) { \
+    for (size_t i = 0; i < n; i++) {                                          \
+        float x = input[i];                                                   \
+        output[i] = x * sigmoid_##tier(DDAF_GELU_K0 *                         \
+                                       (x + DDAF_GELU_K1 * x * x * x));       \
+    }                                                                         \
+}                                                                             \
+static void swish_scalar_##tier(const float* input, float* output, size_t n) {\
+    for (size_t i = 0; i < n; i++) {                                          \
+        output[i] = input[i] * sigmoid_##tier(input[i]);                      \
+    }                                                                         \
+}                                                                             \
+static void sigmoid_scalar_##tier(const float* input, float* output,         \
+                                  size_t n) {                                 \
+    for (size_t i = 0; i < n; i++) {                                          \
+        output[i] = sigmoid_##tier(input[i]);                                 \
+    }                                                                         \
+}                                                                             \
+static void tanh_scalar_##tier(const float* input, float* output, size_t n) { \
+    for (size_t i = 0; i < n; i++) {                                          \
+        output[i] = 2.0f * sigmoid_##tier(2.0f * input[i]) - 1.0f;            \
+    }                                                                         \
+}                                                                             \
+static void exp_array_scalar_##tier(const float* input, float* output,       \
+                                    size_t n) {                               \
+    for (size_t i = 0; i < n; i++) {                                          \
+        output[i] = exp_fn(input[i]);                                         \
+    }                                                                         \
+}
+
+DDAF_SCALAR_TIER_KERNELS(fast, exp_fast_scalar)
+DDAF_SCALAR_TIER_KERNELS(fastest, exp_fastest_scalar)
+
+static const ddaf_kernel_table_t kernels_scalar[DDAF_PRECISION_COUNT] = {
+    { gelu_scalar, swish_scalar, sigmoid_scalar,
+      tanh_scalar, exp_array_scalar, lut_scalar },
+    { gelu_scalar_fast, swish_scalar_fast, sigmoid_scalar_fast,
+      tanh_scalar_fast, exp_array_scalar_fast, lut_scalar },
+    { gelu_scalar_fastest, swish_scalar_fastest, sigmoid_scalar_fastest,
+      tanh_scalar_fastest, exp_array_scalar_fastest, lut_scalar }
+};
+
+static void f16_widen_scalar(const uint16_t* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_half_to_float(input[i]);
+    }
+}
+
+static void f16_narrow_scalar(const float* input, uint16_t* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_float_to_half(input[i]);
+    }
+}
+
+static void bf16_widen_scalar(const uint16_t* input, float* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_bf16_to_float(input[i]);
+    }
+}
+
+static void bf16_narrow_scalar(const float* input, uint16_t* output, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        output[i] = ddaf_float_to_bf16(input[i]);
+    }
+}
+
+static const ddaf_convert_table_t convert_scalar = {
+    { f16_widen_scalar, bf16_widen_scalar },
+    { f16_narrow_scalar, bf16_narrow_scalar }
+};
+
+#ifdef DDAF_X86_DISPATCH
+
+/* ------------------------------------------------------------------ */
+/* SSE4.2                                                             */
+/* ------------------------------------------------------------------ */
+
+#define DDAF_TARGET_SSE42 __attribute__((target("sse4.2")))
+
+static inline DDAF_TARGET_SSE42 __m128 exp_sse42(__m128 x) {
+    x = _mm_min_ps(x, _mm_set1_ps(DDAF_EXP_HI));
+    x = _mm_max_ps(x, _mm_set1_ps(DDAF_EXP_LO));
+
+    __m128 fx = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(DDAF_LN2_HI)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(DDAF_LN2_LO)));
+
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(DDAF_EXP_P0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP_P1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP_P2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP_P3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP_P4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP_P5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, x2), x), _mm_set1_ps(1.0f));
+
+    __m128i e = _mm_add_epi32(_mm_cvtps_epi32(fx), _mm_set1_epi32(127));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+}
+
+/* x / (1 + exp(-z)) */
+static inline DDAF_TARGET_SSE42 __m128 scaled_sigmoid_sse42(__m128 x, __m128 z) {
+    __m128 e = exp_sse42(_mm_sub_ps(_mm_setzero_ps(), z));
+    return _mm_div_ps(x, _mm_add_ps(_mm_set1_ps(1.0f), e));
+}
+
+static DDAF_TARGET_SSE42 void gelu_sse42(const float* input, float* output,
+                                          size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(input + i);
+        __m128 x3 = _mm_mul_ps(_mm_mul_ps(x, x), x);
+        __m128 u = _mm_add_ps(x, _mm_mul_ps(_mm_set1_ps(DDAF_GELU_K1), x3));
+        u = _mm_mul_ps(u, _mm_set1_ps(DDAF_GELU_K0));
+        _mm_storeu_ps(output + i, scaled_sigmoid_sse42(x, u));
+    }
+    gelu_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_SSE42 void swish_sse42(const float* input, float* output,
+                                           size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(input + i);
+        _mm_storeu_ps(output + i, scaled_sigmoid_sse42(x, x));
+    }
+    swish_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_SSE42 void sigmoid_sse42(const float* input, float* output,
+                                             size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(input + i);
+        _mm_storeu_ps(output + i, scaled_sigmoid_sse42(_mm_set1_ps(1.0f), x));
+    }
+    sigmoid_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_SSE42 void tanh_sse42(const float* input, float* output,
+                                          size_t n) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(input + i);
+        __m128 ax = _mm_andnot_ps(sign_mask, x);
+
+        /* Large |x|: 1 - 2 / (exp(2|x|) + 1) */
+        __m128 e = exp_sse42(_mm_add_ps(ax, ax));
+        __m128 big = _mm_sub_ps(_mm_set1_ps(1.0f),
+                                _mm_div_ps(_mm_set1_ps(2.0f),
+                                           _mm_add_ps(e, _mm_set1_ps(1.0f))));
+        big = _mm_or_ps(big, _mm_and_ps(sign_mask, x));
+
+        /* Small |x|: odd polynomial */
+        __m128 x2 = _mm_mul_ps(x, x);
+        __m128 p = _mm_set1_ps(DDAF_TANH_P0);
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(DDAF_TANH_P1));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(DDAF_TANH_P2));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(DDAF_TANH_P3));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(DDAF_TANH_P4));
+        __m128 small = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, x2), x), x);
+
+        __m128 is_small = _mm_cmplt_ps(ax, _mm_set1_ps(DDAF_TANH_SMALL));
+        _mm_storeu_ps(output + i, _mm_blendv_ps(big, small, is_small));
+    }
+    tanh_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_SSE42 void exp_array_sse42(const float* input, float* output,
+                                              size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(output + i, exp_sse42(_mm_loadu_ps(input + i)));
+    }
+    exp_array_scalar(input + i, output + i, n - i);
+}
+
+static inline DDAF_TARGET_SSE42 __m128 pow2_sse42(__m128 fx) {
+    __m128i e = _mm_add_epi32(_mm_cvtps_epi32(fx), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+
+static inline DDAF_TARGET_SSE42 __m128 exp_fast_sse42(__m128 x) {
+    x = _mm_min_ps(x, _mm_set1_ps(DDAF_EXP_HI));
+    x = _mm_max_ps(x, _mm_set1_ps(DDAF_EXP_LO));
+    __m128 fx = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(DDAF_LN2_HI)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(DDAF_LN2_LO)));
+    __m128 y = _mm_set1_ps(DDAF_EXP3_C3);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP3_C2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP3_C1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP3_C0));
+    return _mm_mul_ps(y, pow2_sse42(fx));
+}
+
+static inline DDAF_TARGET_SSE42 __m128 exp_fastest_sse42(__m128 x) {
+    x = _mm_min_ps(x, _mm_set1_ps(DDAF_EXP_HI));
+    x = _mm_max_ps(x, _mm_set1_ps(DDAF_EXP_LO));
+    __m128 fx = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(DDAF_LN2_HI)));
+    __m128 y = _mm_set1_ps(DDAF_EXP2_C2);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP2_C1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(DDAF_EXP2_C0));
+    return _mm_mul_ps(y, pow2_sse42(fx));
+}
+
+/* a / b via reciprocal estimate refined by one Newton-Raphson step */
+static inline DDAF_TARGET_SSE42 __m128 div_fast_sse42(__m128 a, __m128 b) {
+    __m128 r = _mm_rcp_ps(b);
+    r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(b, r)));
+    return _mm_mul_ps(a, r);
+}
+
+static inline DDAF_TARGET_SSE42 __m128 div_fastest_sse42(__m128 a, __m128 b) {
+    return _mm_mul_ps(a, _mm_rcp_ps(b));
+}
+
+#define DDAF_SSE42_TIER_KERNELS(tier)                                         \
+static inline DDAF_TARGET_SSE42 __m128 scaled_sigmoid_sse42_##tier(__m128 x,  \
+                                                             __m128 z) {      \
+    __m128 e = exp_##tier##_sse42(_mm_sub_ps(_mm_setzero_ps(), z));           \
+    return div_##tier##_sse42(x, _mm_add_ps(_mm_set1_ps(1.0f), e));           \
+}                                                                             \
+static DDAF_TARGET_SSE42 void gelu_sse42_##tier(const float* input,           \
+                                                float* output, size_t n) {    \
+    size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                              \
+        __m128 x = _mm_loadu_ps(input + i);                                   \
+        __m128 x3 = _mm_mul_ps(_mm_mul_ps(x, x), x);                          \
+        __m128 u = _mm_add_ps(x, _mm_mul_ps(_mm_set1_ps(DDAF_GELU_K1), x3));  \
+        u = _mm_mul_ps(u, _mm_set1_ps(DDAF_GELU_K0));                         \
+        _mm_storeu_ps(output + i, scaled_sigmoid_sse42_##tier(x, u));         \
+    }                                                                         \
+    gelu_scalar_##tier(input + i, output + i, n - i);                         \
+}                                                                             \
+static DDAF_TARGET_SSE42 void swish_sse42_##tier(const float* input,          \
+                                                 float* output, size_t n) {   \
+    size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                              \
+        __m128 x = _mm_loadu_ps(input + i);                                   \
+        _mm_storeu_ps(output + i, scaled_sigmoid_sse42_##tier(x, x));         \
+    }                                                                         \
+    swish_scalar_##tier(input + i, output + i, n - i);                        \
+}                                                                             \
+static DDAF_TARGET_SSE42 void sigmoid_sse42_##tier(const float* input,        \
+                                                   float* output, size_t n) { \
+    size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                              \
+        __m128 x = _mm_loadu_ps(input + i);                                   \
+        _mm_storeu_ps(output + i,                                             \
+                      scaled_sigmoid_sse42_##tier(_mm_set1_ps(1.0f), x));     \
+    }                                                                         \
+    sigmoid_scalar_##tier(input + i, output + i, n - i);                      \
+}                                                                             \
+static DDAF_TARGET_SSE42 void tanh_sse42_##tier(const float* input,           \
+                                                float* output, size_t n) {    \
+    size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                              \
+        __m128 x = _mm_loadu_ps(input + i);                                   \
+        __m128 s = scaled_sigmoid_sse42_##tier(_mm_set1_ps(2.0f),             \
+                                               _mm_add_ps(x, x));             \
+        _mm_storeu_ps(output + i, _mm_sub_ps(s, _mm_set1_ps(1.0f)));          \
+    }                                                                         \
+    tanh_scalar_##tier(input + i, output + i, n - i);                         \
+}                                                                             \
+static DDAF_TARGET_SSE42 void exp_array_sse42_##tier(const float* input,      \
+                                                     float* output, size_t n) {\
+    size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                              \
+        _mm_storeu_ps(output + i, exp_##tier##_sse42(_mm_loadu_ps(input + i)));\
+    }                                                                         \
+    exp_array_scalar_##tier(input + i, output + i, n - i);                    \
+}
+
+DDAF_SSE42_TIER_KERNELS(fast)
+DDAF_SSE42_TIER_KERNELS(fastest)
+
+static const ddaf_kernel_table_t kernels_sse42[DDAF_PRECISION_COUNT] = {
+    { gelu_sse42, swish_sse42, sigmoid_sse42,
+      tanh_sse42, exp_array_sse42, lut_scalar },
+    { gelu_sse42_fast, swish_sse42_fast, sigmoid_sse42_fast,
+      tanh_sse42_fast, exp_array_sse42_fast, lut_scalar },
+    { gelu_sse42_fastest, swish_sse42_fastest, sigmoid_sse42_fastest,
+      tanh_sse42_fastest, exp_array_sse42_fastest, lut_scalar }
+};
+
+/* ------------------------------------------------------------------ */
+/* AVX2 + FMA                                                         */
+/* ------------------------------------------------------------------ */
+
+#define DDAF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+static inline DDAF_TARGET_AVX2 __m256 exp_avx2(__m256 x) {
+    x = _mm256_min_ps(x, _mm256_set1_ps(DDAF_EXP_HI));
+    x = _mm256_max_ps(x, _mm256_set1_ps(DDAF_EXP_LO));
+
+    __m256 fx = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(DDAF_LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(DDAF_LN2_HI), x);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(DDAF_LN2_LO), x);
+
+    __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(DDAF_EXP_P0);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP_P1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP_P2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP_P3));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP_P4));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP_P5));
+    y = _mm256_add_ps(_mm256_fmadd_ps(y, x2, x), _mm256_set1_ps(1.0f));
+
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(fx), _mm256_set1_epi32(127));
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(e, 23)));
+}
+
+static inline DDAF_TARGET_AVX2 __m256 scaled_sigmoid_avx2(__m256 x, __m256 z) {
+    __m256 e = exp_avx2(_mm256_sub_ps(_mm256_setzero_ps(), z));
+    return _mm256_div_ps(x, _mm256_add_ps(_mm256_set1_ps(1.0f), e));
+}
+
+static DDAF_TARGET_AVX2 void gelu_avx2(const float* input, float* output,
+                                        size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        __m256 x3 = _mm256_mul_ps(_mm256_mul_ps(x, x), x);
+        __m256 u = _mm256_fmadd_ps(_mm256_set1_ps(DDAF_GELU_K1), x3, x);
+        u = _mm256_mul_ps(u, _mm256_set1_ps(DDAF_GELU_K0));
+        _mm256_storeu_ps(output + i, scaled_sigmoid_avx2(x, u));
+    }
+    gelu_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX2 void swish_avx2(const float* input, float* output,
+                                         size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        _mm256_storeu_ps(output + i, scaled_sigmoid_avx2(x, x));
+    }
+    swish_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX2 void sigmoid_avx2(const float* input, float* output,
+                                           size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        _mm256_storeu_ps(output + i,
+                         scaled_sigmoid_avx2(_mm256_set1_ps(1.0f), x));
+    }
+    sigmoid_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX2 void tanh_avx2(const float* input, float* output,
+                                        size_t n) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        __m256 ax = _mm256_andnot_ps(sign_mask, x);
+
+        __m256 e = exp_avx2(_mm256_add_ps(ax, ax));
+        __m256 big = _mm256_sub_ps(_mm256_set1_ps(1.0f),
+                                   _mm256_div_ps(_mm256_set1_ps(2.0f),
+                                                 _mm256_add_ps(e, _mm256_set1_ps(1.0f))));
+        big = _mm256_or_ps(big, _mm256_and_ps(sign_mask, x));
+
+        __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 p = _mm256_set1_ps(DDAF_TANH_P0);
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(DDAF_TANH_P1));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(DDAF_TANH_P2));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(DDAF_TANH_P3));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(DDAF_TANH_P4));
+        __m256 small = _mm256_fmadd_ps(_mm256_mul_ps(p, x2), x, x);
+
+        __m256 is_small = _mm256_cmp_ps(ax, _mm256_set1_ps(DDAF_TANH_SMALL),
+                                        _CMP_LT_OQ);
+        _mm256_storeu_ps(output + i, _mm256_blendv_ps(big, small, is_small));
+    }
+    tanh_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX2 void exp_array_avx2(const float* input, float* output,
+                                            size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(output + i, exp_avx2(_mm256_loadu_ps(input + i)));
+    }
+    exp_array_scalar(input + i, output + i, n - i);
+}
+
+static inline DDAF_TARGET_AVX2 __m256 pow2_avx2(__m256 fx) {
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(fx), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+
+static inline DDAF_TARGET_AVX2 __m256 exp_fast_avx2(__m256 x) {
+    x = _mm256_min_ps(x, _mm256_set1_ps(DDAF_EXP_HI));
+    x = _mm256_max_ps(x, _mm256_set1_ps(DDAF_EXP_LO));
+    __m256 fx = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(DDAF_LN2_HI), x);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(DDAF_LN2_LO), x);
+    __m256 y = _mm256_set1_ps(DDAF_EXP3_C3);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP3_C2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP3_C1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP3_C0));
+    return _mm256_mul_ps(y, pow2_avx2(fx));
+}
+
+static inline DDAF_TARGET_AVX2 __m256 exp_fastest_avx2(__m256 x) {
+    x = _mm256_min_ps(x, _mm256_set1_ps(DDAF_EXP_HI));
+    x = _mm256_max_ps(x, _mm256_set1_ps(DDAF_EXP_LO));
+    __m256 fx = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(DDAF_LN2_HI), x);
+    __m256 y = _mm256_set1_ps(DDAF_EXP2_C2);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP2_C1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(DDAF_EXP2_C0));
+    return _mm256_mul_ps(y, pow2_avx2(fx));
+}
+
+/* a / b via reciprocal estimate refined by one Newton-Raphson step */
+static inline DDAF_TARGET_AVX2 __m256 div_fast_avx2(__m256 a, __m256 b) {
+    __m256 r = _mm256_rcp_ps(b);
+    r = _mm256_mul_ps(r, _mm256_fnmadd_ps(b, r, _mm256_set1_ps(2.0f)));
+    return _mm256_mul_ps(a, r);
+}
+
+static inline DDAF_TARGET_AVX2 __m256 div_fastest_avx2(__m256 a, __m256 b) {
+    return _mm256_mul_ps(a, _mm256_rcp_ps(b));
+}
+
+#define DDAF_AVX2_TIER_KERNELS(tier)                                          \
+static inline DDAF_TARGET_AVX2 __m256 scaled_sigmoid_avx2_##tier(__m256 x,    \
+                                                                 __m256 z) {  \
+    __m256 e = exp_##tier##_avx2(_mm256_sub_ps(_mm256_setzero_ps(), z));      \
+    return div_##tier##_avx2(x, _mm256_add_ps(_mm256_set1_ps(1.0f), e));      \
+}                                                                             \
+static DDAF_TARGET_AVX2 void gelu_avx2_##tier(const float* input,             \
+                                              float* output, size_t n) {      \
+    size_t i = 0;                                                             \
+    for (; i + 8 <= n; i += 8) {                                              \
+        __m256 x = _mm256_loadu_ps(input + i);                                \
+        __m256 x3 = _mm256_mul_ps(_mm256_mul_ps(x, x), x);                    \
+        __m256 u = _mm256_fmadd_ps(_mm256_set1_ps(DDAF_GELU_K1), x3, x);      \
+        u = _mm256_mul_ps(u, _mm256_set1_ps(DDAF_GELU_K0));                   \
+        _mm256_storeu_ps(output + i, scaled_sigmoid_avx2_##tier(x, u));       \
+    }                                                                         \
+    gelu_scalar_##tier(input + i, output + i, n - i);                         \
+}                                                                             \
+static DDAF_TARGET_AVX2 void swish_avx2_##tier(const float* input,            \
+                                               float* output, size_t n) {     \
+    size_t i = 0;                                                             \
+    for (; i + 8 <= n; i += 8) {                                              \
+        __m256 x = _mm256_loadu_ps(input + i);                                \
+        _mm256_storeu_ps(output + i, scaled_sigmoid_avx2_##tier(x, x));       \
+    }                                                                         \
+    swish_scalar_##tier(input + i, output + i, n - i);                        \
+}                                                                             \
+static DDAF_TARGET_AVX2 void sigmoid_avx2_##tier(const float* input,          \
+                                                 float* output, size_t n) {   \
+    size_t i = 0;                                                             \
+    for (; i + 8 <= n; i += 8) {                                              \
+        __m256 x = _mm256_loadu_ps(input + i);                                \
+        __m256 one = _mm256_set1_ps(1.0f);                                    \
+        _mm256_storeu_ps(output + i, scaled_sigmoid_avx2_##tier(one, x));     \
+    }                                                                         \
+    sigmoid_scalar_##tier(input + i, output + i, n - i);                      \
+}                                                                             \
+static DDAF_TARGET_AVX2 void tanh_avx2_##tier(const float* input,             \
+                                              float* output, size_t n) {      \
+    size_t i = 0;                                                             \
+    for (; i + 8 <= n; i += 8) {                                              \
+        __m256 x = _mm256_loadu_ps(input + i);                                \
+        __m256 s = scaled_sigmoid_avx2_##tier(_mm256_set1_ps(2.0f),           \
+                                              _mm256_add_ps(x, x));           \
+        _mm256_storeu_ps(output + i, _mm256_sub_ps(s, _mm256_set1_ps(1.0f))); \
+    }                                                                         \
+    tanh_scalar_##tier(input + i, output + i, n - i);                         \
+}                                                                             \
+static DDAF_TARGET_AVX2 void exp_array_avx2_##tier(const float* input,        \
+                                                   float* output, size_t n) { \
+    size_t i = 0;                                                             \
+    for (; i + 8 <= n; i += 8) {                                              \
+        __m256 x = _mm256_loadu_ps(input + i);                                \
+        _mm256_storeu_ps(output + i, exp_##tier##_avx2(x));                   \
+    }                                                                         \
+    exp_array_scalar_##tier(input + i, output + i, n - i);                    \
+}
+
+DDAF_AVX2_TIER_KERNELS(fast)
+DDAF_AVX2_TIER_KERNELS(fastest)
+
+/* Baked table interpolation: one gather per coefficient, Horner in f */
+static DDAF_TARGET_AVX2 void lut_avx2(const ddaf_lut_t* lut, const float* input,
+                                       float* output, size_t n) {
+    const __m256 x_min = _mm256_set1_ps(lut->x_min);
+    const __m256 x_max = _mm256_set1_ps(lut->x_max);
+    const __m256 inv_step = _mm256_set1_ps(lut->inv_step);
+    const __m256 u_max = _mm256_set1_ps(lut->u_max);
+    const __m256 slope = _mm256_set1_ps(lut->tail_slope);
+    const __m256i last = _mm256_set1_epi32((int)lut->n_segments - 1);
+    const __m256i stride = _mm256_set1_epi32((int)lut->stride);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 zero = _mm256_setzero_ps();
+    bool cubic = lut->stride == 4;
+    size_t i = 0;
+    
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        __m256 u = _mm256_mul_ps(_mm256_sub_ps(x, x_min), inv_step);
+        u = _mm256_max_ps(zero, _mm256_min_ps(u_max, u));
+        
+        __m256i k = _mm256_min_epi32(_mm256_cvttps_epi32(u), last);
+        __m256 f = _mm256_sub_ps(u, _mm256_cvtepi32_ps(k));
+        __m256i idx = _mm256_mullo_epi32(k, stride);
+        
+        __m256 y = _mm256_i32gather_ps(lut->coeffs, _mm256_add_epi32(idx, one), 4);
+        if (cubic) {
+            __m256 c2 = _mm256_i32gather_ps(lut->coeffs,
+                                            _mm256_add_epi32(idx, _mm256_set1_epi32(2)), 4);
+            __m256 c3 = _mm256_i32gather_ps(lut->coeffs,
+                                            _mm256_add_epi32(idx, _mm256_set1_epi32(3)), 4);
+            y = _mm256_fmadd_ps(f, _mm256_fmadd_ps(f, c3, c2), y);
+        }
+        y = _mm256_fmadd_ps(f, y, _mm256_i32gather_ps(lut->coeffs, idx, 4));
+        y = _mm256_fmadd_ps(slope, _mm256_max_ps(zero, _mm256_sub_ps(x, x_max)), y);
+        _mm256_storeu_ps(output + i, y);
+    }
+    lut_scalar(lut, input + i, output + i, n - i);
+}
+
+static const ddaf_kernel_table_t kernels_avx2[DDAF_PRECISION_COUNT] = {
+    { gelu_avx2, swish_avx2, sigmoid_avx2,
+      tanh_avx2, exp_array_avx2, lut_avx2 },
+    { gelu_avx2_fast, swish_avx2_fast, sigmoid_avx2_fast,
+      tanh_avx2_fast, exp_array_avx2_fast, lut_avx2 },
+    { gelu_avx2_fastest, swish_avx2_fastest, sigmoid_avx2_fastest,
+      tanh_avx2_fastest, exp_array_avx2_fastest, lut_avx2 }
+};
+
+/* Storage conversion; every AVX2 part also has F16C, checked at startup */
+#define DDAF_TARGET_F16C __attribute__((target("avx2,f16c")))
+
+static DDAF_TARGET_F16C void f16_widen_avx2(const uint16_t* input,
+                                            float* output, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i*)(input + i));
+        _mm256_storeu_ps(output + i, _mm256_cvtph_ps(h));
+    }
+    f16_widen_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_F16C void f16_narrow_avx2(const float* input,
+                                             uint16_t* output, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(input + i),
+                                    _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(output + i), h);
+    }
+    f16_narrow_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX2 void bf16_widen_avx2(const uint16_t* input,
+                                             float* output, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i*)(input + i)));
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_slli_epi32(w, 16));
+    }
+    bf16_widen_scalar(input + i, output + i, n - i);
+}
+
+/* Round to nearest even on the integer bits, NaNs kept quiet */
+static DDAF_TARGET_AVX2 void bf16_narrow_avx2(const float* input,
+                                              uint16_t* output, size_t n) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i quiet = _mm256_set1_epi32(0x40);
+    size_t i = 0;
+    
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        __m256i bits = _mm256_castps_si256(x);
+        __m256i high = _mm256_srli_epi32(bits, 16);
+        __m256i lsb = _mm256_and_si256(high, one);
+        __m256i rounded = _mm256_srli_epi32(
+            _mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb)), 16);
+        __m256 nan = _mm256_cmp_ps(x, x, _CMP_UNORD_Q);
+        rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(high, quiet),
+                                     _mm256_castps_si256(nan));
+        
+        /* Pack within lanes, then gather the two low quadwords */
+        __m256i packed = _mm256_packus_epi32(rounded, rounded);
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+        _mm_storeu_si128((__m128i*)(output + i), _mm256_castsi256_si128(packed));
+    }
+    bf16_narrow_scalar(input + i, output + i, n - i);
+}
+
+static const ddaf_convert_table_t convert_avx2 = {
+    { f16_widen_avx2, bf16_widen_avx2 },
+    { f16_narrow_avx2, bf16_narrow_avx2 }
+};
+
+/* ------------------------------------------------------------------ */
+/* AVX-512F                                                           */
+/* ------------------------------------------------------------------ */
+
+#define DDAF_TARGET_AVX512 __attribute__((target("avx512f")))
+
+static inline DDAF_TARGET_AVX512 __m512 exp_avx512(__m512 x) {
+    x = _mm512_min_ps(x, _mm512_set1_ps(DDAF_EXP_HI));
+    x = _mm512_max_ps(x, _mm512_set1_ps(DDAF_EXP_LO));
+
+    __m512 fx = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(DDAF_LOG2E)),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(DDAF_LN2_HI), x);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(DDAF_LN2_LO), x);
+
+    __m512 x2 = _mm512_mul_ps(x, x);
+    __m512 y = _mm512_set1_ps(DDAF_EXP_P0);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP_P1));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP_P2));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP_P3));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP_P4));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP_P5));
+    y = _mm512_add_ps(_mm512_fmadd_ps(y, x2, x), _mm512_set1_ps(1.0f));
+
+    __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(fx), _mm512_set1_epi32(127));
+    return _mm512_mul_ps(y, _mm512_castsi512_ps(_mm512_slli_epi32(e, 23)));
+}
+
+static inline DDAF_TARGET_AVX512 __m512 scaled_sigmoid_avx512(__m512 x, __m512 z) {
+    __m512 e = exp_avx512(_mm512_sub_ps(_mm512_setzero_ps(), z));
+    return _mm512_div_ps(x, _mm512_add_ps(_mm512_set1_ps(1.0f), e));
+}
+
+static DDAF_TARGET_AVX512 void gelu_avx512(const float* input, float* output,
+                                            size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        __m512 x3 = _mm512_mul_ps(_mm512_mul_ps(x, x), x);
+        __m512 u = _mm512_fmadd_ps(_mm512_set1_ps(DDAF_GELU_K1), x3, x);
+        u = _mm512_mul_ps(u, _mm512_set1_ps(DDAF_GELU_K0));
+        _mm512_storeu_ps(output + i, scaled_sigmoid_avx512(x, u));
+    }
+    gelu_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void swish_avx512(const float* input, float* output,
+                                             size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        _mm512_storeu_ps(output + i, scaled_sigmoid_avx512(x, x));
+    }
+    swish_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void sigmoid_avx512(const float* input, float* output,
+                                               size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        _mm512_storeu_ps(output + i,
+                         scaled_sigmoid_avx512(_mm512_set1_ps(1.0f), x));
+    }
+    sigmoid_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void tanh_avx512(const float* input, float* output,
+                                            size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        __m512 ax = _mm512_abs_ps(x);
+
+        __m512 e = exp_avx512(_mm512_add_ps(ax, ax));
+        __m512 big = _mm512_sub_ps(_mm512_set1_ps(1.0f),
+                                   _mm512_div_ps(_mm512_set1_ps(2.0f),
+                                                 _mm512_add_ps(e, _mm512_set1_ps(1.0f))));
+        big = _mm512_castsi512_ps(_mm512_or_si512(
+            _mm512_castps_si512(big),
+            _mm512_and_si512(_mm512_castps_si512(x),
+                             _mm512_set1_epi32((int)0x80000000u))));
+
+        __m512 x2 = _mm512_mul_ps(x, x);
+        __m512 p = _mm512_set1_ps(DDAF_TANH_P0);
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(DDAF_TANH_P1));
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(DDAF_TANH_P2));
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(DDAF_TANH_P3));
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(DDAF_TANH_P4));
+        __m512 small = _mm512_fmadd_ps(_mm512_mul_ps(p, x2), x, x);
+
+        __mmask16 is_small = _mm512_cmp_ps_mask(ax, _mm512_set1_ps(DDAF_TANH_SMALL),
+                                                _CMP_LT_OQ);
+        _mm512_storeu_ps(output + i, _mm512_mask_blend_ps(is_small, big, small));
+    }
+    tanh_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void exp_array_avx512(const float* input, float* output,
+                                                size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(output + i, exp_avx512(_mm512_loadu_ps(input + i)));
+    }
+    exp_array_scalar(input + i, output + i, n - i);
+}
+
+static inline DDAF_TARGET_AVX512 __m512 pow2_avx512(__m512 fx) {
+    __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(fx), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+}
+
+static inline DDAF_TARGET_AVX512 __m512 exp_fast_avx512(__m512 x) {
+    x = _mm512_min_ps(x, _mm512_set1_ps(DDAF_EXP_HI));
+    x = _mm512_max_ps(x, _mm512_set1_ps(DDAF_EXP_LO));
+    __m512 fx = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(DDAF_LN2_HI), x);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(DDAF_LN2_LO), x);
+    __m512 y = _mm512_set1_ps(DDAF_EXP3_C3);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP3_C2));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP3_C1));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP3_C0));
+    return _mm512_mul_ps(y, pow2_avx512(fx));
+}
+
+static inline DDAF_TARGET_AVX512 __m512 exp_fastest_avx512(__m512 x) {
+    x = _mm512_min_ps(x, _mm512_set1_ps(DDAF_EXP_HI));
+    x = _mm512_max_ps(x, _mm512_set1_ps(DDAF_EXP_LO));
+    __m512 fx = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(DDAF_LOG2E)),
+                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(DDAF_LN2_HI), x);
+    __m512 y = _mm512_set1_ps(DDAF_EXP2_C2);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP2_C1));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(DDAF_EXP2_C0));
+    return _mm512_mul_ps(y, pow2_avx512(fx));
+}
+
+/* a / b via reciprocal estimate refined by one Newton-Raphson step */
+static inline DDAF_TARGET_AVX512 __m512 div_fast_avx512(__m512 a, __m512 b) {
+    __m512 r = _mm512_rcp14_ps(b);
+    r = _mm512_mul_ps(r, _mm512_fnmadd_ps(b, r, _mm512_set1_ps(2.0f)));
+    return _mm512_mul_ps(a, r);
+}
+
+static inline DDAF_TARGET_AVX512 __m512 div_fastest_avx512(__m512 a, __m512 b) {
+    return _mm512_mul_ps(a, _mm512_rcp14_ps(b));
+}
+
+#define DDAF_AVX512_TIER_KERNELS(tier)                                        \
+static inline DDAF_TARGET_AVX512 __m512 scaled_sigmoid_avx512_##tier(         \
+    __m512 x, __m512 z) {                                                     \
+    __m512 e = exp_##tier##_avx512(_mm512_sub_ps(_mm512_setzero_ps(), z));    \
+    return div_##tier##_avx512(x, _mm512_add_ps(_mm512_set1_ps(1.0f), e));    \
+}                                                                             \
+static DDAF_TARGET_AVX512 void gelu_avx512_##tier(const float* input,         \
+                                                  float* output, size_t n) {  \
+    size_t i = 0;                                                             \
+    for (; i + 16 <= n; i += 16) {                                            \
+        __m512 x = _mm512_loadu_ps(input + i);                                \
+        __m512 x3 = _mm512_mul_ps(_mm512_mul_ps(x, x), x);                    \
+        __m512 u = _mm512_fmadd_ps(_mm512_set1_ps(DDAF_GELU_K1), x3, x);      \
+        u = _mm512_mul_ps(u, _mm512_set1_ps(DDAF_GELU_K0));                   \
+        _mm512_storeu_ps(output + i, scaled_sigmoid_avx512_##tier(x, u));     \
+    }                                                                         \
+    gelu_scalar_##tier(input + i, output + i, n - i);                         \
+}                                                                             \
+static DDAF_TARGET_AVX512 void swish_avx512_##tier(const float* input,        \
+                                                   float* output, size_t n) { \
+    size_t i = 0;                                                             \
+    for (; i + 16 <= n; i += 16) {                                            \
+        __m512 x = _mm512_loadu_ps(input + i);                                \
+        _mm512_storeu_ps(output + i, scaled_sigmoid_avx512_##tier(x, x));     \
+    }                                                                         \
+    swish_scalar_##tier(input + i, output + i, n - i);                        \
+}                                                                             \
+static DDAF_TARGET_AVX512 void sigmoid_avx512_##tier(const float* input,      \
+                                                     float* output,           \
+                                                     size_t n) {              \
+    size_t i = 0;                                                             \
+    for (; i + 16 <= n; i += 16) {                                            \
+        __m512 x = _mm512_loadu_ps(input + i);                                \
+        __m512 one = _mm512_set1_ps(1.0f);                                    \
+        _mm512_storeu_ps(output + i, scaled_sigmoid_avx512_##tier(one, x));   \
+    }                                                                         \
+    sigmoid_scalar_##tier(input + i, output + i, n - i);                      \
+}                                                                             \
+static DDAF_TARGET_AVX512 void tanh_avx512_##tier(const float* input,         \
+                                                  float* output, size_t n) {  \
+    size_t i = 0;                                                             \
+    for (; i + 16 <= n; i += 16) {                                            \
+        __m512 x = _mm512_loadu_ps(input + i);                                \
+        __m512 s = scaled_sigmoid_avx512_##tier(_mm512_set1_ps(2.0f),         \
+                                                _mm512_add_ps(x, x));         \
+        _mm512_storeu_ps(output + i, _mm512_sub_ps(s, _mm512_set1_ps(1.0f))); \
+    }                                                                         \
+    tanh_scalar_##tier(input + i, output + i, n - i);                         \
+}                                                                             \
+static DDAF_TARGET_AVX512 void exp_array_avx512_##tier(const float* input,    \
+                                                       float* output,         \
+                                                       size_t n) {            \
+    size_t i = 0;                                                             \
+    for (; i + 16 <= n; i += 16) {                                            \
+        __m512 x = _mm512_loadu_ps(input + i);                                \
+        _mm512_storeu_ps(output + i, exp_##tier##_avx512(x));                 \
+    }                                                                         \
+    exp_array_scalar_##tier(input + i, output + i, n - i);                    \
+}
+
+DDAF_AVX512_TIER_KERNELS(fast)
+DDAF_AVX512_TIER_KERNELS(fastest)
+
+/* Baked table interpolation: one gather per coefficient, Horner in f */
+static DDAF_TARGET_AVX512 void lut_avx512(const ddaf_lut_t* lut, const float* input,
+                                       float* output, size_t n) {
+    const __m512 x_min = _mm512_set1_ps(lut->x_min);
+    const __m512 x_max = _mm512_set1_ps(lut->x_max);
+    const __m512 inv_step = _mm512_set1_ps(lut->inv_step);
+    const __m512 u_max = _mm512_set1_ps(lut->u_max);
+    const __m512 slope = _mm512_set1_ps(lut->tail_slope);
+    const __m512i last = _mm512_set1_epi32((int)lut->n_segments - 1);
+    const __m512i stride = _mm512_set1_epi32((int)lut->stride);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512 zero = _mm512_setzero_ps();
+    bool cubic = lut->stride == 4;
+    size_t i = 0;
+    
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        __m512 u = _mm512_mul_ps(_mm512_sub_ps(x, x_min), inv_step);
+        u = _mm512_max_ps(zero, _mm512_min_ps(u_max, u));
+        
+        __m512i k = _mm512_min_epi32(_mm512_cvttps_epi32(u), last);
+        __m512 f = _mm512_sub_ps(u, _mm512_cvtepi32_ps(k));
+        __m512i idx = _mm512_mullo_epi32(k, stride);
+        
+        __m512 y = _mm512_i32gather_ps(_mm512_add_epi32(idx, one), lut->coeffs, 4);
+        if (cubic) {
+            __m512 c2 = _mm512_i32gather_ps(_mm512_add_epi32(idx, _mm512_set1_epi32(2)),
+                                            lut->coeffs, 4);
+            __m512 c3 = _mm512_i32gather_ps(_mm512_add_epi32(idx, _mm512_set1_epi32(3)),
+                                            lut->coeffs, 4);
+            y = _mm512_fmadd_ps(f, _mm512_fmadd_ps(f, c3, c2), y);
+        }
+        y = _mm512_fmadd_ps(f, y, _mm512_i32gather_ps(idx, lut->coeffs, 4));
+        y = _mm512_fmadd_ps(slope, _mm512_max_ps(zero, _mm512_sub_ps(x, x_max)), y);
+        _mm512_storeu_ps(output + i, y);
+    }
+    lut_scalar(lut, input + i, output + i, n - i);
+}
+
+static const ddaf_kernel_table_t kernels_avx512[DDAF_PRECISION_COUNT] = {
+    { gelu_avx512, swish_avx512, sigmoid_avx512,
+      tanh_avx512, exp_array_avx512, lut_avx512 },
+    { gelu_avx512_fast, swish_avx512_fast, sigmoid_avx512_fast,
+      tanh_avx512_fast, exp_array_avx512_fast, lut_avx512 },
+    { gelu_avx512_fastest, swish_avx512_fastest, sigmoid_avx512_fastest,
+      tanh_avx512_fastest, exp_array_avx512_fastest, lut_avx512 }
+};
+
+static DDAF_TARGET_AVX512 void f16_widen_avx512(const uint16_t* input,
+                                                float* output, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i h = _mm256_loadu_si256((const __m256i*)(input + i));
+        _mm512_storeu_ps(output + i, _mm512_cvtph_ps(h));
+    }
+    f16_widen_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void f16_narrow_avx512(const float* input,
+                                                 uint16_t* output, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(input + i),
+                                    _MM_FROUND_TO_NEAREST_INT |
+                                    _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256((__m256i*)(output + i), h);
+    }
+    f16_narrow_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void bf16_widen_avx512(const uint16_t* input,
+                                                 float* output, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i w = _mm512_cvtepu16_epi32(
+            _mm256_loadu_si256((const __m256i*)(input + i)));
+        _mm512_storeu_si512(output + i, _mm512_slli_epi32(w, 16));
+    }
+    bf16_widen_scalar(input + i, output + i, n - i);
+}
+
+static DDAF_TARGET_AVX512 void bf16_narrow_avx512(const float* input,
+                                                  uint16_t* output, size_t n) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i bias = _mm512_set1_epi32(0x7fff);
+    const __m512i quiet = _mm512_set1_epi32(0x40);
+    size_t i = 0;
+    
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        __m512i bits = _mm512_castps_si512(x);
+        __m512i high = _mm512_srli_epi32(bits, 16);
+        __m512i lsb = _mm512_and_si512(high, one);
+        __m512i rounded = _mm512_srli_epi32(
+            _mm512_add_epi32(bits, _mm512_add_epi32(bias, lsb)), 16);
+        __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+        rounded = _mm512_mask_mov_epi32(rounded, nan,
+                                        _mm512_or_si512(high, quiet));
+        _mm256_storeu_si256((__m256i*)(output + i),
+                            _mm512_cvtepi32_epi16(rounded));
+    }
+    bf16_narrow_scalar(input + i, output + i, n - i);
+}
+
+/* Native rounding; flushes float denormals to zero */
+#define DDAF_TARGET_AVX512_BF16 __attribute__((target("avx512f,avx512bf16")))
+
+static DDAF_TARGET_AVX512_BF16 void bf16_narrow_avx512bf16(const float* input,
+                                                           uint16_t* output,
+                                                           size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(input + i));
+        _mm256_storeu_si256((__m256i*)(output + i), (__m256i)h);
+    }
+    bf16_narrow_scalar(input + i, output + i, n - i);
+}
+
+static const ddaf_convert_table_t convert_avx512 = {
+    { f16_widen_avx512, bf16_widen_avx512 },
+    { f16_narrow_avx512, bf16_narrow_avx512 }
+};
+
+static const ddaf_convert_table_t convert_avx512_bf16 = {
+    { f16_widen_avx512, bf16_widen_avx512 },
+    { f16_narrow_avx512, bf16_narrow_avx512bf16 }
+};
+
+/* ------------------------------------------------------------------ */
+/* CPUID detection                                                    */
+/* ------------------------------------------------------------------ */
+
+static uint64_t read_xcr0(void) {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static ddaf_isa_t detect_isa(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return DDAF_ISA_SCALAR;
+
+    bool has_sse42 = (ecx & bit_SSE4_2) != 0;
+    bool has_fma = (ecx & bit_FMA) != 0;
+    bool has_osxsave = (ecx & bit_OSXSAVE) != 0;
+    if (!has_sse42) return DDAF_ISA_SCALAR;
+    if (!has_osxsave) return DDAF_ISA_SSE42;
+
+    /* OS must save YMM (bits 1-2) and ZMM/opmask (bits 5-7) state */
+    uint64_t xcr0 = read_xcr0();
+    bool os_avx = (xcr0 & 0x6) == 0x6;
+    bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return DDAF_ISA_SSE42;
+    bool has_avx2 = (ebx & bit_AVX2) != 0;
+    bool has_avx512f = (ebx & bit_AVX512F) != 0;
+
+    if (has_avx512f && os_avx512) return DDAF_ISA_AVX512;
+    if (has_avx2 && has_fma && os_avx) return DDAF_ISA_AVX2;
+    return DDAF_ISA_SSE42;
+}
+
+/* Conversion extensions; only used once the ISA above enables AVX state */
+static bool cpu_f16c = false;
+static bool cpu_avx512bf16 = false;
+
+static void detect_convert(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        cpu_f16c = (ecx & bit_F16C) != 0;
+    }
+    if (__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+        cpu_avx512bf16 = (eax & bit_AVX512BF16) != 0;
+    }
+}
+
+#else
+
+static ddaf_isa_t detect_isa(void) {
+    return DDAF_ISA_SCALAR;
+}
+
+static void detect_convert(void) {
+}
+
+#endif /* DDAF_X86_DISPATCH */
+
+/* ------------------------------------------------------------------ */
+/* Dispatch                                                           */
+/* ------------------------------------------------------------------ */
+
+static ddaf_isa_t supported_isa = DDAF_ISA_SCALAR;
+static ddaf_isa_t active_isa = DDAF_ISA_SCALAR;
+static const ddaf_kernel_table_t* active_kernels = NULL;
+static const ddaf_convert_table_t* active_convert = &convert_scalar;
+
+/* Returns the DDAF_PRECISION_COUNT tier tables for an ISA */
+static const ddaf_kernel_table_t* kernels_for_isa(ddaf_isa_t isa) {
+#ifdef DDAF_X86_DISPATCH
+    switch (isa) {
+        case DDAF_ISA_AVX512: return kernels_avx512;
+        case DDAF_ISA_AVX2:   return kernels_avx2;
+        case DDAF_ISA_SSE42:  return kernels_sse42;
+        default:              break;
+    }
+#else
+    (void)isa;
+#endif
+    return kernels_scalar;
+}
+
+static const ddaf_convert_table_t* convert_for_isa(ddaf_isa_t isa) {
+#ifdef DDAF_X86_DISPATCH
+    switch (isa) {
+        case DDAF_ISA_AVX512:
+            return cpu_avx512bf16 ? &convert_avx512_bf16 : &convert_avx512;
+        case DDAF_ISA_AVX2:
+            return cpu_f16c ? &convert_avx2 : &convert_scalar;
+        default:
+            break;
+    }
+#else
+    (void)isa;
+#endif
+    return &convert_scalar;
+}
+
+static void init_dispatch(void) {
+    supported_isa = detect_isa();
+    detect_convert();
+    active_isa = supported_isa;
+    active_convert = convert_for_isa(active_isa);
+    active_kernels = kernels_for_isa(active_isa);
+}
+
+#ifdef __GNUC__
+__attribute__((constructor))
+#endif
+static void ddaf_kernels_startup(void) {
+    if (!active_kernels) init_dispatch();
+}
+
+const ddaf_kernel_table_t* ddaf_get_kernels(ddaf_precision_t precision) {
+    if (!active_kernels) init_dispatch();
+    if ((unsigned)precision >= DDAF_PRECISION_COUNT) {
+        precision = DDAF_PRECISION_EXACT;
+    }
+    return &active_kernels[precision];
+}
+
+ddaf_isa_t ddaf_get_isa(void) {
+    if (!active_kernels) init_dispatch();
+    return active_isa;
+}
+
+int ddaf_set_isa(ddaf_isa_t isa) {
+    if (!active_kernels) init_dispatch();
+    if (isa > supported_isa) return -1;
+
+    active_isa = isa;
+    active_convert = convert_for_isa(isa);
+    active_kernels = kernels_for_isa(isa);
+    return 0;
+}
+
+void ddaf_widen(ddaf_dtype_t dtype, const uint16_t* input, float* output,
+                size_t n) {
+    if (!active_kernels) init_dispatch();
+    active_convert->widen[dtype](input, output, n);
+}
+
+void ddaf_narrow(ddaf_dtype_t dtype, const float* input, uint16_t* output,
+                 size_t n) {
+    if (!active_kernels) init_dispatch();
+    active_convert->narrow[dtype](input, output, n);
+}
+
+/* Public array kernels */
+void ddaf_gelu_f32(const float* input, float* output, size_t n) {
+    if (!input || !output) return;
+    ddaf_get_kernels(DDAF_PRECISION_EXACT)->gelu(input, output, n);
+}
+
+void ddaf_swish_f32(const float* input, float* output, size_t n) {
+    if (!input || !output) return;
+    ddaf_get_kernels(DDAF_PRECISION_EXACT)->swish(input, output, n);
+}
+
+void ddaf_sigmoid_f32(const float* input, float* output, size_t n) {
+    if (!input || !output) return;
+    ddaf_get_kernels(DDAF_PRECISION_EXACT)->sigmoid(input, output, n);
+}
+
+void ddaf_tanh_f32(const float* input, float* output, size_t n) {
+    if (!input || !output) return;
+    ddaf_get_kernels(DDAF_PRECISION_EXACT)->tanh(input, output, n);
+}
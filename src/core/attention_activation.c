@@ -11,13 +11,42 @@
 #include <string.h>
 #include <math.h>
 
-static void compute_attention(float* query, float* key, float* value,
-                               float* attention_weights, size_t d_model,
-                               size_t n_heads, size_t seq_len, float temperature) {
-    size_t head_dim = d_model / n_heads;
+/* One call's attention inputs, shared by its (head, query block) tiles */
+typedef struct {
+    const float* query;
+    const float* key;
+    float* attention_weights;   /* n_heads x seq_len x seq_len */
+    float* row_summary;
+    size_t n_heads;
+    size_t head_dim;
+    size_t seq_len;
+    size_t n_blocks;            /* Query blocks per head */
+    float scale;
+} attention_call_t;
+
+/*
+ * Tiles per pool chunk: about DDAF_PARALLEL_GRAIN scores, so short
+ * sequences batch several tiles and small calls stay inline
+ */
+static size_t tile_grain(size_t seq_len) {
+    return DDAF_MAX((size_t)1, DDAF_PARALLEL_GRAIN /
+                               (DDAF_ATTENTION_BLOCK_Q * seq_len));
+}
+
+/* Dense softmax rows of tiles [begin, end); each owns its weight rows */
+static void dense_tiles(void* arg, size_t begin, size_t end) {
+    const attention_call_t* call = (const attention_call_t*)arg;
+    size_t seq_len = call->seq_len;
+    size_t head_dim = call->head_dim;
     
-    for (size_t h = 0; h < n_heads; h++) {
-        for (size_t i = 0; i < seq_len; i++) {
+    for (size_t tile = begin; tile < end; tile++) {
+        size_t h = tile / call->n_blocks;
+        size_t i0 = (tile % call->n_blocks) * DDAF_ATTENTION_BLOCK_Q;
+        size_t i1 = DDAF_MIN(i0 + DDAF_ATTENTION_BLOCK_Q, seq_len);
+        
+        for (size_t i = i0; i < i1; i++) {
+            float* weights = call->attention_weights +
+                             h * seq_len * seq_len + i * seq_len;
             float sum = 0.0f;
             float max_score = -1e9f;
             
@@ -27,12 +56,12 @@ static void compute_attention(float* query, float* key, float* value,
                 for (size_t d = 0; d < head_dim; d++) {
                     size_t q_idx = h * seq_len * head_dim + i * head_dim + d;
                     size_t k_idx = h * seq_len * head_dim + j * head_dim + d;
-                    score += query[q_idx] * key[k_idx];
+                    score += call->query[q_idx] * call->key[k_idx];
                 }
-                score /= (sqrtf((float)head_dim) * temperature);
+                score /= call->scale;
                 
                 /* Store for softmax */
-                attention_weights[h * seq_len * seq_len + i * seq_len + j] = score;
+                weights[j] = score;
                 if (score > max_score) {
                     max_score = score;
                 }
@@ -40,27 +69,110 @@ static void compute_attention(float* query, float* key, float* value,
             
             /* Softmax */
             for (size_t j = 0; j < seq_len; j++) {
-                size_t idx = h * seq_len * seq_len + i * seq_len + j;
-                attention_weights[idx] = expf(attention_weights[idx] - max_score);
-                sum += attention_weights[idx];
+                weights[j] = expf(weights[j] - max_score);
+                sum += weights[j];
             }
             
             for (size_t j = 0; j < seq_len; j++) {
-                size_t idx = h * seq_len * seq_len + i * seq_len + j;
-                attention_weights[idx] /= sum;
+                weights[j] /= sum;
             }
         }
     }
 }
 
-static int attention_forward(ddaf_context_t* ctx, const float* input,
-                             float* output, size_t size) {
-    ddaf_attention_params_t* params = (ddaf_attention_params_t*)ctx->params;
-    if (!params) return -1;
+static void compute_attention(attention_call_t* call) {
+    size_t n_tiles = call->n_heads * call->n_blocks;
+    ddaf_parallel_for(n_tiles, tile_grain(call->seq_len), dense_tiles, call);
+}
+
+/*
+ * Mean attention weight of query positions [begin, end) from the dense
+ * matrix. Only seq_len distinct values exist, so they are reduced once
+ * here rather than per output element.
+ */
+static void dense_row_summary(void* arg, size_t begin, size_t end) {
+    const attention_call_t* call = (const attention_call_t*)arg;
+    size_t seq_len = call->seq_len;
+    float inv_count = 1.0f / (float)(call->n_heads * seq_len);
     
+    for (size_t i = begin; i < end; i++) {
+        float attention_sum = 0.0f;
+        
+        /* Aggregate attention weights */
+        for (size_t h = 0; h < call->n_heads; h++) {
+            const float* row = call->attention_weights +
+                               h * seq_len * seq_len + i * seq_len;
+            for (size_t k = 0; k < seq_len; k++) {
+                attention_sum += row[k];
+            }
+        }
+        call->row_summary[i] = attention_sum * inv_count;
+    }
+}
+
+/* Per-position activation shared by the blocks of a forward call */
+typedef struct {
+    const ddaf_context_t* ctx;
+    const float* input;         /* Backward: saved forward input */
+    const float* grad_output;
+    float* grad_input;
+    size_t seq_len;
+} attention_apply_t;
+
+/* Attention-weighted activation of elements [start, start + n) */
+static void attention_block(void* arg, const float* input, float* output,
+                            size_t start, size_t n) {
+    const attention_apply_t* apply = (const attention_apply_t*)arg;
+    const ddaf_context_t* ctx = apply->ctx;
+    const ddaf_attention_params_t* params =
+        (const ddaf_attention_params_t*)ctx->params;
+    const ddaf_kernel_table_t* kernels = ddaf_get_kernels(ctx->precision);
+    
+    /* Frozen inference: interpolate the baked curves */
+    const ddaf_baked_t* baked = (const ddaf_baked_t*)ctx->baked;
+    float base_act[DDAF_KERNEL_BLOCK];
+    float attention_act[DDAF_KERNEL_BLOCK];
+    
+    for (size_t j = 0; j < n; j++) {
+        size_t seq_idx = (start + j) % apply->seq_len;
+        attention_act[j] = input[j] * params->row_summary[seq_idx];
+    }
+    
+    /* Apply activation with attention weighting */
+    if (baked) {
+        kernels->lut(&baked->gelu, input, base_act, n);
+        kernels->lut(&baked->swish, attention_act, attention_act, n);
+    } else {
+        kernels->gelu(input, base_act, n);
+        kernels->swish(attention_act, attention_act, n);
+    }
+    
+    for (size_t j = 0; j < n; j++) {
+        output[j] = 0.5f * base_act[j] + 0.5f * attention_act[j];
+    }
+}
+
+/*
+ * Query, key and value of one sequence and its per-position attention
+ * summary: the mean softmax weight of each query row over heads and keys
+ */
+static void attention_scores(ddaf_context_t* ctx, const float* input,
+                             size_t size) {
+    ddaf_attention_params_t* params = (ddaf_attention_params_t*)ctx->params;
     size_t seq_len = params->seq_len;
     if (size < seq_len) seq_len = size;
     
+    /*
+     * A softmax row sums to exactly 1, so the mean weight is 1/seq_len
+     * whatever the scores. Dense mode evaluates them to validate this.
+     */
+    if (params->mode != DDAF_ATTENTION_DENSE) {
+        for (size_t i = 0; i < seq_len; i++) {
+            params->row_summary[i] = 1.0f / (float)seq_len;
+        }
+        return;
+    }
+    
     /* Initialize query, key, value from input */
     for (size_t i = 0; i < seq_len && i < size; i++) {
         for (size_t d = 0; d < params->d_model; d++) {
@@ -73,33 +185,65 @@ static int attention_forward(ddaf_context_t* ctx, const float* input,
         }
     }
     
-    /* Compute attention */
-    compute_attention(params->query, params->key, params->value,
-                     params->attention_weights, params->d_model,
-                     params->n_heads, seq_len, params->temperature);
+    size_t head_dim = params->d_model / params->n_heads;
+    attention_call_t call = {
+        .query = params->query,
+        .key = params->key,
+        .attention_weights = params->attention_weights,
+        .row_summary = params->row_summary,
+        .n_heads = params->n_heads,
+        .head_dim = head_dim,
+        .seq_len = seq_len,
+        .n_blocks = (seq_len + DDAF_ATTENTION_BLOCK_Q - 1) /
+                    DDAF_ATTENTION_BLOCK_Q,
+        .scale = sqrtf((float)head_dim) * params->temperature
+    };
     
-    /* Apply attention-weighted activation */
-    for (size_t i = 0; i < size; i++) {
-        float attention_sum = 0.0f;
-        size_t seq_idx = i % seq_len;
+    /* Compute attention and its per-position summary over (head, block) tiles */
+    compute_attention(&call);
+    ddaf_parallel_for(seq_len, tile_grain(seq_len) * DDAF_ATTENTION_BLOCK_Q,
+                      dense_row_summary, &call);
+}
+
+static int attention_forward(ddaf_context_t* ctx, const float* input,
+                             float* output, size_t size) {
+    ddaf_attention_params_t* params = (ddaf_attention_params_t*)ctx->params;
+    if (!params) return -1;
+    attention_scores(ctx, input, size);
+    
+    size_t seq_len = DDAF_MIN(params->seq_len, size);
+    
+    /* Apply attention-weighted activation in cache-resident blocks */
+    attention_apply_t apply = { ctx, NULL, NULL, NULL, seq_len };
+    ddaf_parallel_sweep(size, attention_block, &apply, input, output);
+    
+    return 0;
+}
+
+/* Gradient of elements [begin, end) */
+static void attention_backward_task(void* arg, size_t begin, size_t end) {
+    const attention_apply_t* apply = (const attention_apply_t*)arg;
+    const ddaf_attention_params_t* params =
+        (const ddaf_attention_params_t*)apply->ctx->params;
+    
+    /* Summary cached by the forward pass */
+    const float* row_summary = params->row_summary;
+    const float* input = apply->input;
+    
+    for (size_t i = begin; i < end; i++) {
+        float attention_sum = row_summary[i % apply->seq_len];
         
-        /* Aggregate attention weights */
-        for (size_t h = 0; h < params->n_heads; h++) {
-            for (size_t j = 0; j < seq_len; j++) {
-                size_t att_idx = h * seq_len * seq_len + seq_idx * seq_len + j;
-                attention_sum += params->attention_weights[att_idx];
-            }
+        if (input) {
+            apply->grad_input[i] = apply->grad_output[i] *
+                                   (0.5f * ddaf_gelu_grad(input[i]) + 0.5f * attention_sum *
+                                    ddaf_swish_grad(input[i] * attention_sum));
+            continue;
         }
-        attention_sum /= (params->n_heads * seq_len);
-        
-        /* Apply activation with attention weighting */
-        float base_act = ddaf_gelu(input[i]);
-        float attention_act = ddaf_swish(input[i] * attention_sum);
         
-        output[i] = 0.5f * base_act + 0.5f * attention_act;
+        /* Gradient through attention-weighted activation */
+        float grad_scale = 0.5f + 0.5f * attention_sum;
+        apply->grad_input[i] = apply->grad_output[i] * grad_scale;
     }
-    
-    return 0;
 }
 
 static int attention_backward(ddaf_context_t* ctx, const float* grad_output,
@@ -110,64 +254,170 @@ static int attention_backward(ddaf_context_t* ctx, const float* grad_output,
     size_t seq_len = params->seq_len;
     if (size < seq_len) seq_len = size;
     
-    for (size_t i = 0; i < size; i++) {
-        float attention_sum = 0.0f;
-        size_t seq_idx = i % seq_len;
-        
-        /* Aggregate attention weights */
-        for (size_t h = 0; h < params->n_heads; h++) {
-            for (size_t j = 0; j < seq_len; j++) {
-                size_t att_idx = h * seq_len * seq_len + seq_idx * seq_len + j;
-                attention_sum += params->attention_weights[att_idx];
-            }
-        }
-        attention_sum /= (params->n_heads * seq_len);
-        
-        /* Gradient through attention-weighted activation */
-        float grad_scale = 0.5f + 0.5f * attention_sum;
-        grad_input[i] = grad_output[i] * grad_scale;
+    attention_apply_t apply = { ctx, ddaf_saved_input(ctx, size), grad_output,
+                                grad_input, seq_len };
+    ddaf_parallel_for(size, DDAF_PARALLEL_GRAIN, attention_backward_task,
+                      &apply);
+    
+    return 0;
+}
+
+/* Sequences one at a time, each with its own summary */
+static int attention_forward_batched(ddaf_context_t* ctx, const float* input,
+                                     float* output, size_t batch,
+                                     size_t sample_size, unsigned flags) {
+    (void)flags;
+    
+    for (size_t b = 0; b < batch; b++) {
+        size_t offset = b * sample_size;
+        int ret = attention_forward(ctx, input + offset, output + offset,
+                                    sample_size);
+        if (ret != 0) return ret;
     }
     
     return 0;
 }
 
-int ddaf_init_attention(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
-                        size_t seq_len) {
-    if (!ctx) return -1;
-    if (d_model % n_heads != 0) return -1;
+/*
+ * The summary the forward cached is the last sequence's. With the input
+ * kept, each sequence's summary is rebuilt before its gradient, which
+ * leaves the last one in place as the forward did; otherwise every
+ * sequence uses the cached one.
+ */
+static int attention_backward_batched(ddaf_context_t* ctx,
+                                      const float* grad_output,
+                                      float* grad_input, size_t batch,
+                                      size_t sample_size, unsigned flags) {
+    (void)flags;
+    ddaf_attention_params_t* params = (ddaf_attention_params_t*)ctx->params;
+    if (!params) return -1;
     
-    size_t param_size = sizeof(ddaf_attention_params_t) +
-                        d_model * seq_len * sizeof(float) * 3 + /* Q, K, V */
-                        n_heads * seq_len * seq_len * sizeof(float); /* attention */
+    const float* input = ddaf_saved_input(ctx, batch * sample_size);
+    size_t seq_len = DDAF_MIN(params->seq_len, sample_size);
     
-    if (ctx->params) {
-        free(ctx->params);
+    for (size_t b = 0; b < batch; b++) {
+        size_t offset = b * sample_size;
+        if (input) {
+            attention_scores(ctx, input + offset, sample_size);
+        }
+        
+        attention_apply_t apply = { ctx, input ? input + offset : NULL,
+                                    grad_output + offset, grad_input + offset,
+                                    seq_len };
+        ddaf_parallel_for(sample_size, DDAF_PARALLEL_GRAIN,
+                          attention_backward_task, &apply);
     }
     
-    ctx->params = calloc(1, param_size);
-    if (!ctx->params) return -1;
+    return 0;
+}
+
+/*
+ * Allocate a parameter block laid out as the row summary and, in dense mode
+ * only, Q, K, V and the n_heads x seq_len x seq_len weight matrix.
+ */
+static size_t attention_size(size_t d_model, size_t n_heads, size_t seq_len,
+                             ddaf_attention_mode_t mode) {
+    size_t dense_count = (mode == DDAF_ATTENTION_DENSE) ?
+                         d_model * seq_len * 3 +    /* Q, K, V */
+                         n_heads * seq_len * seq_len : 0; /* attention */
+    return sizeof(ddaf_attention_params_t) +
+           seq_len * sizeof(float) +                /* summary */
+           dense_count * sizeof(float);
+}
+
+static ddaf_attention_params_t* attention_alloc(const ddaf_context_t* ctx,
+                                                size_t d_model, size_t n_heads,
+                                                size_t seq_len,
+                                                ddaf_attention_mode_t mode) {
+    ddaf_attention_params_t* params = (ddaf_attention_params_t*)
+        ddaf_ctx_alloc(ctx, attention_size(d_model, n_heads, seq_len, mode));
+    if (!params) return NULL;
     
-    ddaf_attention_params_t* params = (ddaf_attention_params_t*)ctx->params;
     params->d_model = d_model;
     params->n_heads = n_heads;
     params->seq_len = seq_len;
     params->temperature = 1.0f;
+    params->mode = mode;
     
     char* ptr = (char*)params + sizeof(ddaf_attention_params_t);
-    params->query = (float*)ptr;
-    params->key = params->query + d_model * seq_len;
-    params->value = params->key + d_model * seq_len;
-    params->attention_weights = params->value + d_model * seq_len;
-    
-    /* Initialize */
-    memset(params->query, 0, d_model * seq_len * sizeof(float));
-    memset(params->key, 0, d_model * seq_len * sizeof(float));
-    memset(params->value, 0, d_model * seq_len * sizeof(float));
-    memset(params->attention_weights, 0, 
-           n_heads * seq_len * seq_len * sizeof(float));
+    params->row_summary = (float*)ptr;
+    if (mode == DDAF_ATTENTION_DENSE) {
+        params->query = params->row_summary + seq_len;
+        params->key = params->query + d_model * seq_len;
+        params->value = params->key + d_model * seq_len;
+        params->attention_weights = params->value + d_model * seq_len;
+    }
+    
+    return params;
+}
+
+static void attention_relocate(ddaf_context_t* ctx,
+                               const ddaf_relocation_t* reloc) {
+    ddaf_attention_params_t* params = (ddaf_attention_params_t*)ctx->params;
+    
+    params->query = ddaf_relocate_ptr(reloc, params->query);
+    params->key = ddaf_relocate_ptr(reloc, params->key);
+    params->value = ddaf_relocate_ptr(reloc, params->value);
+    params->row_summary = ddaf_relocate_ptr(reloc, params->row_summary);
+    params->attention_weights = ddaf_relocate_ptr(reloc,
+                                                  params->attention_weights);
+}
+
+int ddaf_init_attention(ddaf_context_t* ctx, size_t d_model, size_t n_heads,
+                        size_t seq_len) {
+    if (!ctx) return -1;
+    if (d_model % n_heads != 0) return -1;
+    
+    ddaf_unbake(ctx);
+    ddaf_free_params(ctx);
+    
+    ctx->params = attention_alloc(ctx, d_model, n_heads, seq_len,
+                                  DDAF_ATTENTION_SUMMARY);
+    if (!ctx->params) return -1;
+    ctx->params_size = attention_size(d_model, n_heads, seq_len,
+                                      DDAF_ATTENTION_SUMMARY);
     
     ctx->forward = attention_forward;
+    ctx->forward16 = NULL;
     ctx->backward = attention_backward;
+    ctx->forward_batched = attention_forward_batched;
+    ctx->backward_batched = attention_backward_batched;
+    ctx->relocate = attention_relocate;
+    ctx->state_size = NULL;
+    ctx->forward_workspace = NULL;
+    ctx->backward_workspace = ddaf_saved_input_workspace;
+    
+    return 0;
+}
+
+int ddaf_set_attention_mode(ddaf_context_t* ctx, ddaf_attention_mode_t mode) {
+    if (!ctx) return -1;
+    
+    for (ddaf_context_t* child = ctx->first_child; child;
+         child = child->next_sibling) {
+        if (ddaf_set_attention_mode(child, mode) != 0) return -1;
+    }
+    
+    /* Only leaf attention contexts carry attention parameters */
+    if (ctx->forward != attention_forward || !ctx->params) return 0;
+    
+    ddaf_attention_params_t* old = (ddaf_attention_params_t*)ctx->params;
+    if (old->mode == mode) return 0;
+    
+    /* Re-lay the block so summary mode carries only the summary */
+    ddaf_attention_params_t* params = attention_alloc(ctx, old->d_model,
+                                                      old->n_heads,
+                                                      old->seq_len, mode);
+    if (!params) return -1;
+    
+    /* Q, K and V are rebuilt from the input by each dense forward */
+    memcpy(params->row_summary, old->row_summary, old->seq_len * sizeof(float));
+    params->temperature = old->temperature;
+    
+    ddaf_ctx_free(ctx, old);
+    ctx->params = params;
+    ctx->params_size = attention_size(params->d_model, params->n_heads,
+                                      params->seq_len, mode);
     
     return 0;
 }
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Context tree compaction
+ * Gathers every block of a context tree into one aligned allocation
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+size_t ddaf_tree_count(const ddaf_context_t* ctx) {
+    size_t count = 1;
+    for (const ddaf_context_t* child = ctx->first_child; child;
+         child = child->next_sibling) {
+        count += ddaf_tree_count(child);
+    }
+    return count;
+}
+
+size_t ddaf_tree_collect(ddaf_context_t* ctx, ddaf_context_t** nodes,
+                         size_t index) {
+    nodes[index++] = ctx;
+    for (ddaf_context_t* child = ctx->first_child; child;
+         child = child->next_sibling) {
+        index = ddaf_tree_collect(child, nodes, index);
+    }
+    return index;
+}
+
+void* ddaf_relocate_ptr(const ddaf_relocation_t* reloc, const void* ptr) {
+    const char* p = (const char*)ptr;
+    if (!p) return NULL;
+    
+    for (size_t i = 0; i < reloc->count; i++) {
+        const ddaf_moved_block_t* block = &reloc->blocks[i];
+        if (p >= block->old_base && p < block->old_base + block->size) {
+            return block->new_base + (p - block->old_base);
+        }
+    }
+    return (void*)ptr;
+}
+
+/* Copy one block to the arena cursor and record the move */
+static void move_block(ddaf_relocation_t* reloc, ddaf_moved_block_t* blocks,
+                       char** cursor, const void* old, size_t size,
+                       size_t alignment) {
+    memcpy(*cursor, old, size);
+    
+    ddaf_moved_block_t* block = &blocks[reloc->count++];
+    block->old_base = (const char*)old;
+    block->size = size;
+    block->new_base = *cursor;
+    
+    *cursor += align_up(size, alignment);
+}
+
+int ddaf_compact(ddaf_context_t* ctx) {
+    if (!ctx || ctx->parent) return -1;
+    
+    const ddaf_allocator_t* allocator = &ctx->options.allocator;
+    size_t alignment = ctx->options.alignment ? ctx->options.alignment :
+                                                DDAF_POOL_ALIGNMENT;
+    size_t count = ddaf_tree_count(ctx);
+    
+    /* Up to three blocks per context: struct, params, baked tables */
+    ddaf_context_t** nodes = (ddaf_context_t**)
+        ddaf_allocator_malloc(allocator, count * sizeof(ddaf_context_t*));
+    ddaf_moved_block_t* blocks = (ddaf_moved_block_t*)
+        ddaf_allocator_malloc(allocator, 3 * count * sizeof(ddaf_moved_block_t));
+    if (!nodes || !blocks) {
+        ddaf_allocator_free(allocator, nodes);
+        ddaf_allocator_free(allocator, blocks);
+        return -1;
+    }
+    ddaf_tree_collect(ctx, nodes, 0);
+    
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        const ddaf_context_t* node = nodes[i];
+        if (i > 0) total += align_up(sizeof(ddaf_context_t), alignment);
+        if (node->params) total += align_up(node->params_size, alignment);
+        if (node->baked) total += align_up(node->baked_size, alignment);
+    }
+    
+    char* arena = (char*)ddaf_allocator_malloc(allocator, total + alignment);
+    if (!arena) {
+        ddaf_allocator_free(allocator, nodes);
+        ddaf_allocator_free(allocator, blocks);
+        return -1;
+    }
+    
+    /* The root struct is the caller's handle and stays where it is */
+    ddaf_relocation_t reloc = { blocks, 0 };
+    char* cursor = (char*)align_up((uintptr_t)arena, alignment);
+    for (size_t i = 0; i < count; i++) {
+        const ddaf_context_t* node = nodes[i];
+        if (i > 0) {
+            move_block(&reloc, blocks, &cursor, node,
+                       sizeof(ddaf_context_t), alignment);
+        }
+        if (node->params) {
+            move_block(&reloc, blocks, &cursor, node->params,
+                       node->params_size, alignment);
+        }
+        if (node->baked) {
+            move_block(&reloc, blocks, &cursor, node->baked,
+                       node->baked_size, alignment);
+        }
+    }
+    
+    /* Re-point the tree links, then let each type fix its own params */
+    for (size_t i = 0; i < count; i++) {
+        ddaf_context_t* moved = ddaf_relocate_ptr(&reloc, nodes[i]);
+        moved->parent = ddaf_relocate_ptr(&reloc, moved->parent);
+        moved->first_child = ddaf_relocate_ptr(&reloc, moved->first_child);
+        moved->next_sibling = ddaf_relocate_ptr(&reloc, moved->next_sibling);
+        moved->params = ddaf_relocate_ptr(&reloc, moved->params);
+        moved->baked = ddaf_relocate_ptr(&reloc, moved->baked);
+        
+        if (moved->params && moved->relocate) {
+            moved->relocate(moved, &reloc);
+        }
+        if (moved->baked) {
+            ddaf_relocate_baked((ddaf_baked_t*)moved->baked, &reloc);
+        }
+    }
+    
+    /* Free the old blocks, except those inside a previous arena */
+    const char* old_arena = (const char*)ctx->arena;
+    for (size_t i = 0; i < reloc.count; i++) {
+        const char* old = blocks[i].old_base;
+        if (old_arena && old >= old_arena &&
+            old < old_arena + ctx->arena_size) {
+            continue;
+        }
+        ddaf_allocator_free(allocator, (void*)old);
+    }
+    ddaf_allocator_free(allocator, ctx->arena);
+    
+    ctx->arena = arena;
+    ctx->arena_size = total + alignment;
+    
+    ddaf_allocator_free(allocator, nodes);
+    ddaf_allocator_free(allocator, blocks);
+    
+    return 0;
+}
@@ -11,41 +11,67 @@
 #include <string.h>
 #include <math.h>
 
-static int data_driven_forward(ddaf_context_t* ctx, const float* input,
-                               float* output, size_t size) {
+/* Fold the batch statistics into the running ones */
+static void data_driven_update(ddaf_context_t* ctx, float mean,
+                               float variance) {
     ddaf_data_driven_params_t* params = (ddaf_data_driven_params_t*)ctx->params;
-    if (!params) return -1;
+    if (!params->statistics || ctx->replay) return;
+    
+    float old_mean = params->statistics[0];
+    float old_var = params->statistics[1];
     
-    /* Compute running statistics */
-    float mean = 0.0f;
-    float variance = 0.0f;
+    params->statistics[0] = params->momentum * old_mean + 
+                            (1.0f - params->momentum) * mean;
+    params->statistics[1] = params->momentum * old_var + 
+                            (1.0f - params->momentum) * variance;
+}
+
+/* Batch statistics shared by every block of a call */
+typedef struct {
+    const ddaf_context_t* ctx;
+    const float* input;             /* Backward: saved forward input */
+    const float* grad_output;
+    float* grad_input;
+    float mean;
+    float inv_stddev;
+} data_driven_call_t;
+
+/* Normalize and activate elements [start, start + n); output may be input */
+static void data_driven_block(void* arg, const float* input, float* output,
+                              size_t start, size_t n) {
+    const data_driven_call_t* call = (const data_driven_call_t*)arg;
+    const ddaf_context_t* ctx = call->ctx;
+    const ddaf_data_driven_params_t* params =
+        (const ddaf_data_driven_params_t*)ctx->params;
+    float mean = call->mean;
+    float inv_stddev = call->inv_stddev;
+    const ddaf_kernel_table_t* kernels = ddaf_get_kernels(ctx->precision);
+    const ddaf_baked_t* baked = (const ddaf_baked_t*)ctx->baked;
+    float normalized[DDAF_KERNEL_BLOCK];
+    float base_act[DDAF_KERNEL_BLOCK];
+    float adaptive_act[DDAF_KERNEL_BLOCK];
     
-    for (size_t i = 0; i < size; i++) {
-        mean += input[i];
+    for (size_t j = 0; j < n; j++) {
+        normalized[j] = (input[j] - mean) * inv_stddev;
     }
-    mean /= size;
     
-    for (size_t i = 0; i < size; i++) {
-        float diff = input[i] - mean;
-        variance += diff * diff;
+    if (baked && baked->uniform) {
+        /* Frozen inference: one interpolated curve, no transcendentals */
+        kernels->lut(&baked->combined, normalized, output, n);
+        return;
     }
-    variance /= size;
-    float stddev = sqrtf(variance + DDAF_EPSILON);
     
-    /* Update running statistics */
-    if (params->statistics) {
-        float old_mean = params->statistics[0];
-        float old_var = params->statistics[1];
-        
-        params->statistics[0] = params->momentum * old_mean + 
-                                (1.0f - params->momentum) * mean;
-        params->statistics[1] = params->momentum * old_var + 
-                                (1.0f - params->momentum) * variance;
+    if (baked) {
+        kernels->lut(&baked->gelu, normalized, base_act, n);
+        kernels->lut(&baked->swish, normalized, adaptive_act, n);
+    } else {
+        kernels->gelu(normalized, base_act, n);
+        kernels->swish(normalized, adaptive_act, n);
     }
     
-    /* Apply data-driven activation */
-    for (size_t i = 0; i < size; i++) {
-        float normalized = (input[i] - mean) / stddev;
+    /* Combine base activation with adaptive component */
+    for (size_t j = 0; j < n; j++) {
+        size_t i = start + j;
         
         /* Adaptive weight based on statistics */
         float weight = 1.0f;
@@ -53,50 +79,220 @@ static int data_driven_forward(ddaf_context_t* ctx, const float* input,
             weight = params->adaptive_weights[i];
         }
         
-        /* Combine base activation with adaptive component */
-        float base_act = ddaf_gelu(normalized);
-        float adaptive_act = weight * ddaf_swish(normalized);
-        
-        output[i] = 0.7f * base_act + 0.3f * adaptive_act;
+        output[j] = 0.7f * base_act[j] + 0.3f * weight * adaptive_act[j];
     }
+}
+
+static int data_driven_forward(ddaf_context_t* ctx, const float* input,
+                               float* output, size_t size) {
+    if (!ctx->params) return -1;
+    
+    /* Compute statistics in one blocked sweep over the input */
+    ddaf_moments_t moments;
+    ddaf_moments_compute(input, size, &moments);
+    
+    float mean = (float)moments.mean;
+    float variance = (float)(moments.m2 / (double)size);
+    float stddev = sqrtf(variance + DDAF_EPSILON);
+    data_driven_update(ctx, mean, variance);
+    
+    /* Fused normalize-and-activate pass in cache-resident blocks */
+    data_driven_call_t call = { ctx, NULL, NULL, NULL, mean, 1.0f / stddev };
+    ddaf_parallel_sweep(size, data_driven_block, &call, input, output);
     
     return 0;
 }
 
-static int data_driven_backward(ddaf_context_t* ctx, const float* grad_output,
-                                float* grad_input, size_t size) {
-    ddaf_data_driven_params_t* params = (ddaf_data_driven_params_t*)ctx->params;
-    if (!params) return -1;
+/* 16-bit storage: the same passes, widening and narrowing per block */
+static int data_driven_forward16(ddaf_context_t* ctx, const uint16_t* input,
+                                 uint16_t* output, size_t size,
+                                 ddaf_dtype_t dtype) {
+    if (!ctx->params) return -1;
+    
+    ddaf_moments_t moments;
+    ddaf_moments_compute16(input, size, dtype, &moments);
+    
+    float mean = (float)moments.mean;
+    float variance = (float)(moments.m2 / (double)size);
+    float stddev = sqrtf(variance + DDAF_EPSILON);
+    data_driven_update(ctx, mean, variance);
     
-    /* Compute gradient through data-driven activation */
-    const float* input = (const float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
-    if (!input) return -1;
+    data_driven_call_t call = { ctx, NULL, NULL, NULL, mean, 1.0f / stddev };
+    ddaf_parallel_sweep16(size, data_driven_block, &call, input, output, dtype);
     
-    /* Simplified backward pass */
-    for (size_t i = 0; i < size; i++) {
+    return 0;
+}
+
+/* Gradient at positions [begin, end) of the sample starting at offset */
+static void data_driven_grad(const data_driven_call_t* call, size_t offset,
+                             size_t begin, size_t end) {
+    const ddaf_data_driven_params_t* params =
+        (const ddaf_data_driven_params_t*)call->ctx->params;
+    const float* input = call->input;
+    
+    for (size_t p = begin; p < end; p++) {
+        size_t i = offset + p;
         float weight = 1.0f;
-        if (params->adaptive_weights && i < params->stat_size) {
-            weight = params->adaptive_weights[i];
+        if (params->adaptive_weights && p < params->stat_size) {
+            weight = params->adaptive_weights[p];
+        }
+        
+        if (input) {
+            /* Elementwise derivative; the batch mean and deviation act as constants */
+            float normalized = (input[i] - call->mean) * call->inv_stddev;
+            call->grad_input[i] = call->grad_output[i] * call->inv_stddev *
+                                  (0.7f * ddaf_gelu_grad(normalized) +
+                                   0.3f * weight * ddaf_swish_grad(normalized));
+            continue;
         }
         
         /* Approximate gradient */
-        grad_input[i] = grad_output[i] * (0.7f + 0.3f * weight);
+        call->grad_input[i] = call->grad_output[i] * (0.7f + 0.3f * weight);
     }
+}
+
+static void data_driven_backward_task(void* arg, size_t begin, size_t end) {
+    data_driven_grad((const data_driven_call_t*)arg, 0, begin, end);
+}
+
+static int data_driven_backward(ddaf_context_t* ctx, const float* grad_output,
+                                float* grad_input, size_t size) {
+    if (!ctx->params) return -1;
+    
+    data_driven_call_t call = { ctx, ddaf_saved_input(ctx, size), grad_output,
+                                grad_input, 0.0f, 1.0f };
+    if (call.input) {
+        ddaf_moments_t moments;
+        ddaf_moments_compute(call.input, size, &moments);
+        float variance = (float)(moments.m2 / (double)size);
+        call.mean = (float)moments.mean;
+        call.inv_stddev = 1.0f / sqrtf(variance + DDAF_EPSILON);
+    }
+    
+    ddaf_parallel_for(size, DDAF_PARALLEL_GRAIN, data_driven_backward_task,
+                      &call);
+    return 0;
+}
+
+/*
+ * Normalization of each sample, or one shared by the batch, in pool
+ * scratch. With update set the statistics are folded into the running
+ * ones in sample order. NULL if the pool is exhausted.
+ */
+static data_driven_call_t* data_driven_statistics(ddaf_context_t* ctx,
+                                                  const float* input,
+                                                  size_t batch,
+                                                  size_t sample_size,
+                                                  unsigned flags,
+                                                  bool update) {
+    size_t n_sets = (flags & DDAF_BATCH_PER_SAMPLE) ? batch : 1;
+    size_t count = batch * sample_size / n_sets;
+    data_driven_call_t* calls = (data_driven_call_t*)
+        ddaf_pool_alloc(ctx->pool, n_sets * sizeof(data_driven_call_t));
+    ddaf_moments_t* moments = (ddaf_moments_t*)
+        ddaf_pool_alloc(ctx->pool, n_sets * sizeof(ddaf_moments_t));
+    if (!calls || !moments) return NULL;
+    
+    ddaf_moments_batched(input, n_sets, count, moments);
+    for (size_t s = 0; s < n_sets; s++) {
+        float mean = (float)moments[s].mean;
+        float variance = (float)(moments[s].m2 / (double)count);
+        float stddev = sqrtf(variance + DDAF_EPSILON);
+        if (update) data_driven_update(ctx, mean, variance);
+        
+        data_driven_call_t call = { ctx, NULL, NULL, NULL, mean, 1.0f / stddev };
+        calls[s] = call;
+    }
+    return calls;
+}
+
+static int data_driven_forward_batched(ddaf_context_t* ctx, const float* input,
+                                       float* output, size_t batch,
+                                       size_t sample_size, unsigned flags) {
+    if (!ctx->params) return -1;
+    
+    data_driven_call_t* calls = data_driven_statistics(ctx, input, batch,
+                                                       sample_size, flags,
+                                                       true);
+    if (!calls) return -1;
+    
+    size_t stride = (flags & DDAF_BATCH_PER_SAMPLE) ?
+                    sizeof(data_driven_call_t) : 0;
+    ddaf_parallel_sweep_batched(batch, sample_size, data_driven_block, calls,
+                                stride, input, output);
+    return 0;
+}
+
+typedef struct {
+    const data_driven_call_t* calls;
+    size_t stride;                  /* Calls per sample: 1, or 0 if shared */
+    size_t sample_size;
+} data_driven_batch_t;
+
+static void data_driven_backward_sample(void* arg, size_t sample,
+                                        size_t begin, size_t end) {
+    const data_driven_batch_t* batch = (const data_driven_batch_t*)arg;
+    data_driven_grad(&batch->calls[sample * batch->stride],
+                     sample * batch->sample_size, begin, end);
+}
+
+static int data_driven_backward_batched(ddaf_context_t* ctx,
+                                        const float* grad_output,
+                                        float* grad_input, size_t batch,
+                                        size_t sample_size, unsigned flags) {
+    if (!ctx->params) return -1;
     
+    const float* input = ddaf_saved_input(ctx, batch * sample_size);
+    data_driven_call_t shared = { ctx, NULL, NULL, NULL, 0.0f, 1.0f };
+    data_driven_call_t* calls = &shared;
+    size_t n_sets = 1;
+    if (input) {
+        calls = data_driven_statistics(ctx, input, batch, sample_size, flags,
+                                       false);
+        if (!calls) return -1;
+        if (flags & DDAF_BATCH_PER_SAMPLE) n_sets = batch;
+    }
+    
+    for (size_t s = 0; s < n_sets; s++) {
+        calls[s].input = input;
+        calls[s].grad_output = grad_output;
+        calls[s].grad_input = grad_input;
+    }
+    
+    data_driven_batch_t call = { calls, n_sets > 1 ? 1 : 0, sample_size };
+    ddaf_parallel_samples(batch, sample_size, data_driven_backward_sample,
+                          &call);
     return 0;
 }
 
+static void data_driven_relocate(ddaf_context_t* ctx,
+                                 const ddaf_relocation_t* reloc) {
+    ddaf_data_driven_params_t* params = (ddaf_data_driven_params_t*)ctx->params;
+    
+    params->statistics = ddaf_relocate_ptr(reloc, params->statistics);
+    params->adaptive_weights = ddaf_relocate_ptr(reloc,
+                                                 params->adaptive_weights);
+}
+
+/*
+ * Calls write only the running mean and variance at the head of the
+ * statistics; the rest of the block, adaptive weights included, is read-only
+ */
+static size_t data_driven_state_size(const ddaf_context_t* ctx) {
+    const ddaf_data_driven_params_t* params =
+        (const ddaf_data_driven_params_t*)ctx->params;
+    if (params->stat_size < 2) return ctx->params_size;
+    return sizeof(ddaf_data_driven_params_t) + 2 * sizeof(float);
+}
+
 int ddaf_init_data_driven(ddaf_context_t* ctx, size_t stat_size) {
     if (!ctx) return -1;
     
     size_t param_size = sizeof(ddaf_data_driven_params_t) + 
                         stat_size * sizeof(float) * 2; /* stats + weights */
     
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_unbake(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     ddaf_data_driven_params_t* params = (ddaf_data_driven_params_t*)ctx->params;
@@ -113,7 +309,13 @@ int ddaf_init_data_driven(ddaf_context_t* ctx, size_t stat_size) {
     }
     
     ctx->forward = data_driven_forward;
+    ctx->forward16 = data_driven_forward16;
     ctx->backward = data_driven_backward;
+    ctx->forward_batched = data_driven_forward_batched;
+    ctx->backward_batched = data_driven_backward_batched;
+    ctx->relocate = data_driven_relocate;
+    ctx->state_size = data_driven_state_size;
+    ctx->backward_workspace = ddaf_saved_input_workspace;
     
     return 0;
 }
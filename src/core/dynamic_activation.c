@@ -11,15 +11,16 @@
 #include <string.h>
 #include <math.h>
 
-static int dynamic_forward(ddaf_context_t* ctx, const float* input,
-                           float* output, size_t size) {
+/* Update the time-varying parameters of elements [start, start + n) */
+static void dynamic_update(ddaf_context_t* ctx, const float* input,
+                           size_t start, size_t n) {
     ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
-    if (!params) return -1;
     
-    /* Update time-varying parameters */
-    for (size_t i = 0; i < params->param_count && i < size; i++) {
+    for (size_t j = 0; j < n && start + j < params->param_count; j++) {
+        size_t i = start + j;
+        
         /* Update velocity */
-        float gradient = input[i] * 0.01f; /* Simplified gradient */
+        float gradient = input[j] * 0.01f; /* Simplified gradient */
         params->velocity[i] = params->decay_rate * params->velocity[i] + 
                               params->update_rate * gradient;
         
@@ -30,55 +31,228 @@ static int dynamic_forward(ddaf_context_t* ctx, const float* input,
         params->time_varying_params[i] = DDAF_MAX(-2.0f, 
             DDAF_MIN(2.0f, params->time_varying_params[i]));
     }
+}
+
+/*
+ * Elements [start, start + n); output may be input. Each element's
+ * parameter is updated just before it is used, as a full update pass
+ * ahead of the activation would. Blocks touch disjoint parameters, so
+ * they can run on any thread.
+ */
+static void dynamic_block(void* arg, const float* input, float* output,
+                          size_t start, size_t n) {
+    ddaf_context_t* ctx = (ddaf_context_t*)arg;
+    ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
+    const ddaf_kernel_table_t* kernels = ddaf_get_kernels(ctx->precision);
+    const ddaf_baked_t* baked = (const ddaf_baked_t*)ctx->baked;
+    
+    /* Frozen inference: parameters stay fixed, curves are interpolated */
+    if (baked && baked->uniform) {
+        kernels->lut(&baked->combined, input, output, n);
+        return;
+    }
     
-    /* Apply dynamic activation */
-    for (size_t i = 0; i < size; i++) {
+    /* Update time-varying parameters (frozen once baked) */
+    if (!baked && !ctx->replay) {
+        dynamic_update(ctx, input, start, n);
+    }
+    
+    float scaled[DDAF_KERNEL_BLOCK];
+    float damped[DDAF_KERNEL_BLOCK];
+    
+    for (size_t j = 0; j < n; j++) {
+        size_t i = start + j;
         float param = 1.0f;
         if (i < params->param_count) {
             param = params->time_varying_params[i];
         }
         
-        /* Dynamic combination of activations */
-        float x = input[i];
-        float act1 = ddaf_gelu(x * param);
-        float act2 = ddaf_swish(x / (1.0f + fabsf(param)));
-        
-        output[i] = 0.6f * act1 + 0.4f * act2;
+        float x = input[j];
+        scaled[j] = x * param;
+        if (baked) {
+            damped[j] = x * (i < params->param_count ? baked->damping[i] : 0.5f);
+        } else {
+            damped[j] = x / (1.0f + fabsf(param));
+        }
     }
     
+    /* Dynamic combination of activations */
+    if (baked) {
+        kernels->lut(&baked->gelu, scaled, scaled, n);
+        kernels->lut(&baked->swish, damped, damped, n);
+    } else {
+        kernels->gelu(scaled, scaled, n);
+        kernels->swish(damped, damped, n);
+    }
+    
+    for (size_t j = 0; j < n; j++) {
+        output[j] = 0.6f * scaled[j] + 0.4f * damped[j];
+    }
+}
+
+static int dynamic_forward(ddaf_context_t* ctx, const float* input,
+                           float* output, size_t size) {
+    if (!ctx->params) return -1;
+    
+    /* Apply dynamic activation in cache-resident blocks */
+    ddaf_parallel_sweep(size, dynamic_block, ctx, input, output);
+    
     return 0;
 }
 
-static int dynamic_backward(ddaf_context_t* ctx, const float* grad_output,
-                            float* grad_input, size_t size) {
-    ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
-    if (!params) return -1;
+static int dynamic_forward16(ddaf_context_t* ctx, const uint16_t* input,
+                             uint16_t* output, size_t size,
+                             ddaf_dtype_t dtype) {
+    if (!ctx->params) return -1;
     
-    for (size_t i = 0; i < size; i++) {
+    ddaf_parallel_sweep16(size, dynamic_block, ctx, input, output, dtype);
+    
+    return 0;
+}
+
+typedef struct {
+    const ddaf_dynamic_params_t* params;
+    const float* input;             /* Saved forward input, or NULL */
+    const float* grad_output;
+    float* grad_input;
+} dynamic_grad_t;
+
+/* Gradient at positions [begin, end) of the sample starting at offset */
+static void dynamic_grad(const dynamic_grad_t* grad, size_t offset,
+                         size_t begin, size_t end) {
+    const ddaf_dynamic_params_t* params = grad->params;
+    const float* input = grad->input;
+    
+    for (size_t p = begin; p < end; p++) {
+        size_t i = offset + p;
         float param = 1.0f;
-        if (i < params->param_count) {
-            param = params->time_varying_params[i];
+        if (p < params->param_count) {
+            param = params->time_varying_params[p];
+        }
+        
+        if (input) {
+            float damping = 1.0f / (1.0f + fabsf(param));
+            grad->grad_input[i] = grad->grad_output[i] *
+                                  (0.6f * param * ddaf_gelu_grad(input[i] * param) +
+                                   0.4f * damping * ddaf_swish_grad(input[i] * damping));
+            continue;
         }
         
         /* Gradient through dynamic activation */
         float grad_scale = 0.6f * param + 0.4f / (1.0f + fabsf(param));
-        grad_input[i] = grad_output[i] * grad_scale;
+        grad->grad_input[i] = grad->grad_output[i] * grad_scale;
     }
+}
+
+static void dynamic_backward_task(void* arg, size_t begin, size_t end) {
+    dynamic_grad((const dynamic_grad_t*)arg, 0, begin, end);
+}
+
+static int dynamic_backward(ddaf_context_t* ctx, const float* grad_output,
+                            float* grad_input, size_t size) {
+    ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
+    if (!params) return -1;
+    
+    dynamic_grad_t grad = { params, ddaf_saved_input(ctx, size), grad_output,
+                            grad_input };
+    ddaf_parallel_for(size, DDAF_PARALLEL_GRAIN, dynamic_backward_task, &grad);
     
     return 0;
 }
 
+typedef struct {
+    ddaf_context_t* ctx;
+    const float* input;
+    float* output;
+    size_t batch;
+    size_t sample_size;
+} dynamic_batch_t;
+
+/* Positions [begin, end) of every sample, the samples in order */
+static void dynamic_batch_task(void* arg, size_t begin, size_t end) {
+    const dynamic_batch_t* call = (const dynamic_batch_t*)arg;
+    
+    for (size_t start = begin; start < end; start += DDAF_KERNEL_BLOCK) {
+        size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, end - start);
+        for (size_t b = 0; b < call->batch; b++) {
+            size_t offset = b * call->sample_size + start;
+            dynamic_block(call->ctx, call->input + offset,
+                          call->output + offset, start, n);
+        }
+    }
+}
+
+/*
+ * No statistics to share, so flags do not matter. Threads split the
+ * positions and each walks the samples in order, so a parameter takes one
+ * update per sample just as in a loop over samples.
+ */
+static int dynamic_forward_batched(ddaf_context_t* ctx, const float* input,
+                                   float* output, size_t batch,
+                                   size_t sample_size, unsigned flags) {
+    (void)flags;
+    if (!ctx->params) return -1;
+    
+    dynamic_batch_t call = { ctx, input, output, batch, sample_size };
+    size_t blocks = DDAF_MAX(DDAF_PARALLEL_GRAIN / DDAF_KERNEL_BLOCK / batch,
+                             (size_t)1);
+    ddaf_parallel_for(sample_size, blocks * DDAF_KERNEL_BLOCK,
+                      dynamic_batch_task, &call);
+    
+    return 0;
+}
+
+typedef struct {
+    dynamic_grad_t grad;
+    size_t sample_size;
+} dynamic_grad_batch_t;
+
+static void dynamic_backward_sample(void* arg, size_t sample, size_t begin,
+                                    size_t end) {
+    const dynamic_grad_batch_t* batch = (const dynamic_grad_batch_t*)arg;
+    dynamic_grad(&batch->grad, sample * batch->sample_size, begin, end);
+}
+
+static int dynamic_backward_batched(ddaf_context_t* ctx,
+                                    const float* grad_output,
+                                    float* grad_input, size_t batch,
+                                    size_t sample_size, unsigned flags) {
+    (void)flags;
+    ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
+    if (!params) return -1;
+    
+    dynamic_grad_batch_t call = {
+        { params, ddaf_saved_input(ctx, batch * sample_size), grad_output,
+          grad_input },
+        sample_size
+    };
+    ddaf_parallel_samples(batch, sample_size, dynamic_backward_sample, &call);
+    
+    return 0;
+}
+
+static void dynamic_relocate(ddaf_context_t* ctx,
+                             const ddaf_relocation_t* reloc) {
+    ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
+    
+    params->time_varying_params =
+        ddaf_relocate_ptr(reloc, params->time_varying_params);
+    params->velocity = ddaf_relocate_ptr(reloc, params->velocity);
+}
+
+/* Baked parameters no longer move, so only the header is per session */
+static size_t dynamic_state_size(const ddaf_context_t* ctx) {
+    return ctx->baked ? sizeof(ddaf_dynamic_params_t) : ctx->params_size;
+}
+
 int ddaf_init_dynamic(ddaf_context_t* ctx, size_t param_count) {
     if (!ctx) return -1;
     
     size_t param_size = sizeof(ddaf_dynamic_params_t) + 
                         param_count * sizeof(float) * 2; /* params + velocity */
     
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_unbake(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
@@ -97,7 +271,13 @@ int ddaf_init_dynamic(ddaf_context_t* ctx, size_t param_count) {
     }
     
     ctx->forward = dynamic_forward;
+    ctx->forward16 = dynamic_forward16;
     ctx->backward = dynamic_backward;
+    ctx->forward_batched = dynamic_forward_batched;
+    ctx->backward_batched = dynamic_backward_batched;
+    ctx->relocate = dynamic_relocate;
+    ctx->state_size = dynamic_state_size;
+    ctx->backward_workspace = ddaf_saved_input_workspace;
     
     return 0;
 }
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Lookup-table activation for frozen inference
+ * Bakes the current activation curves into interpolated tables
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Curve a * gelu(x) + b * swish(s * x), evaluated in double precision */
+typedef struct {
+    double gelu_coef;
+    double swish_coef;
+    double swish_scale;
+} lut_curve_t;
+
+static double gelu_ref(double x) {
+    return 0.5 * x * (1.0 + tanh(sqrt(2.0 / M_PI) * (x + 0.044715 * x * x * x)));
+}
+
+static double swish_ref(double x) {
+    return x / (1.0 + exp(-x));
+}
+
+static double curve_eval(const lut_curve_t* curve, double x) {
+    return curve->gelu_coef * gelu_ref(x) +
+           curve->swish_coef * swish_ref(curve->swish_scale * x);
+}
+
+static double curve_derivative(const lut_curve_t* curve, double x) {
+    const double h = 1e-5;
+    return (curve_eval(curve, x + h) - curve_eval(curve, x - h)) / (2.0 * h);
+}
+
+static void build_table(ddaf_lut_t* lut, float* coeffs, const lut_curve_t* curve,
+                        float x_min, float x_max, size_t n_segments,
+                        ddaf_interp_t interp) {
+    double step = ((double)x_max - (double)x_min) / (double)n_segments;
+
+    lut->x_min = x_min;
+    lut->x_max = x_max;
+    lut->inv_step = (float)(1.0 / step);
+    lut->u_max = (float)n_segments;
+    lut->n_segments = n_segments;
+    lut->stride = (interp == DDAF_INTERP_CUBIC) ? 4 : 2;
+    lut->tail_slope = (float)(curve->gelu_coef +
+                              curve->swish_coef * curve->swish_scale);
+    lut->coeffs = coeffs;
+
+    for (size_t k = 0; k < n_segments; k++) {
+        double x0 = (double)x_min + step * (double)k;
+        double x1 = x0 + step;
+        double y0 = curve_eval(curve, x0);
+        double y1 = curve_eval(curve, x1);
+        float* c = coeffs + k * lut->stride;
+
+        if (interp == DDAF_INTERP_CUBIC) {
+            /* Hermite segment in the local coordinate f in [0, 1] */
+            double d0 = curve_derivative(curve, x0) * step;
+            double d1 = curve_derivative(curve, x1) * step;
+            c[0] = (float)y0;
+            c[1] = (float)d0;
+            c[2] = (float)(3.0 * (y1 - y0) - 2.0 * d0 - d1);
+            c[3] = (float)(2.0 * (y0 - y1) + d0 + d1);
+        } else {
+            c[0] = (float)y0;
+            c[1] = (float)(y1 - y0);
+        }
+    }
+}
+
+static int bake_leaf(ddaf_context_t* ctx, float x_min, float x_max,
+                     size_t n_segments, ddaf_interp_t interp) {
+    if (!ctx->params) return -1;
+
+    size_t stride = (interp == DDAF_INTERP_CUBIC) ? 4 : 2;
+    size_t table_floats = n_segments * stride;
+    size_t damping_count = 0;
+
+    lut_curve_t combined = { 1.0, 0.0, 1.0 };
+    bool uniform = false;
+
+    switch (ctx->type) {
+        case DDAF_TYPE_DATA_DRIVEN: {
+            ddaf_data_driven_params_t* params =
+                (ddaf_data_driven_params_t*)ctx->params;
+            combined = (lut_curve_t){ 0.7, 0.3, 1.0 };
+            uniform = true;
+            for (size_t i = 0; i < params->stat_size; i++) {
+                if (params->adaptive_weights[i] != 1.0f) {
+                    uniform = false;
+                    break;
+                }
+            }
+            break;
+        }
+        case DDAF_TYPE_DYNAMIC: {
+            ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
+            combined = (lut_curve_t){ 0.6, 0.4, 0.5 };
+            uniform = true;
+            for (size_t i = 0; i < params->param_count; i++) {
+                if (params->time_varying_params[i] != 1.0f) {
+                    uniform = false;
+                    break;
+                }
+            }
+            if (!uniform) damping_count = params->param_count;
+            break;
+        }
+        case DDAF_TYPE_ONLINE:
+        case DDAF_TYPE_ATTENTION:
+            break;
+        default:
+            return -1;
+    }
+
+    size_t baked_size = sizeof(ddaf_baked_t) +
+                        3 * table_floats * sizeof(float) +
+                        damping_count * sizeof(float);
+    ddaf_baked_t* baked = (ddaf_baked_t*)ddaf_ctx_alloc(ctx, baked_size);
+    if (!baked) return -1;
+
+    float* coeffs = (float*)((char*)baked + sizeof(ddaf_baked_t));
+    lut_curve_t gelu_curve = { 1.0, 0.0, 1.0 };
+    lut_curve_t swish_curve = { 0.0, 1.0, 1.0 };
+
+    build_table(&baked->gelu, coeffs, &gelu_curve,
+                x_min, x_max, n_segments, interp);
+    build_table(&baked->swish, coeffs + table_floats, &swish_curve,
+                x_min, x_max, n_segments, interp);
+    build_table(&baked->combined, coeffs + 2 * table_floats, &combined,
+                x_min, x_max, n_segments, interp);
+    baked->uniform = uniform;
+
+    if (damping_count > 0) {
+        ddaf_dynamic_params_t* params = (ddaf_dynamic_params_t*)ctx->params;
+        baked->damping = coeffs + 3 * table_floats;
+        for (size_t i = 0; i < damping_count; i++) {
+            baked->damping[i] = 1.0f / (1.0f + fabsf(params->time_varying_params[i]));
+        }
+    }
+
+    ddaf_ctx_free(ctx, ctx->baked);
+    ctx->baked = baked;
+    ctx->baked_size = baked_size;
+
+    return 0;
+}
+
+int ddaf_bake(ddaf_context_t* ctx, float x_min, float x_max,
+              size_t n_segments, ddaf_interp_t interp) {
+    if (!ctx) return -1;
+    if (!(x_max > x_min) || n_segments == 0) return -1;
+
+    /* Architecture contexts bake their nested activations */
+    if (ctx->first_child) {
+        for (ddaf_context_t* child = ctx->first_child; child;
+             child = child->next_sibling) {
+            int ret = ddaf_bake(child, x_min, x_max, n_segments, interp);
+            if (ret != 0) return ret;
+        }
+        return 0;
+    }
+
+    return bake_leaf(ctx, x_min, x_max, n_segments, interp);
+}
+
+void ddaf_unbake(ddaf_context_t* ctx) {
+    if (!ctx) return;
+
+    for (ddaf_context_t* child = ctx->first_child; child;
+         child = child->next_sibling) {
+        ddaf_unbake(child);
+    }
+
+    ddaf_ctx_free(ctx, ctx->baked);
+    ctx->baked = NULL;
+    ctx->baked_size = 0;
+}
+
+void ddaf_relocate_baked(ddaf_baked_t* baked, const ddaf_relocation_t* reloc) {
+    baked->gelu.coeffs = ddaf_relocate_ptr(reloc, baked->gelu.coeffs);
+    baked->swish.coeffs = ddaf_relocate_ptr(reloc, baked->swish.coeffs);
+    baked->combined.coeffs = ddaf_relocate_ptr(reloc, baked->combined.coeffs);
+    baked->damping = ddaf_relocate_ptr(reloc, baked->damping);
+}
@@ -1,58 +1,256 @@
 /*
  * Copyright (C) 2025, Shyamal Suhana Chandra
- * 
+ *
  * Memory pool implementation for efficient allocation
+ * Chunked bump arena: slabs are linked as the pool grows, and offsets are
+ * global across slabs so marks stay plain byte counts.
  */
 
 #include "ddaf.h"
+#include "ddaf_internal.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
-ddaf_memory_pool_t* ddaf_create_pool(size_t size) {
-    ddaf_memory_pool_t* pool = (ddaf_memory_pool_t*)malloc(sizeof(ddaf_memory_pool_t));
-    if (!pool) return NULL;
+#if defined(__unix__) || defined(__APPLE__)
+#define DDAF_POOL_MMAP 1
+#include <sys/mman.h>
+#endif
+
+#define DDAF_HUGE_PAGE_SIZE (2u * 1024u * 1024u)
+#define DDAF_MIN_SLAB_SIZE 4096u
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static ddaf_pool_slab_t* slab_create(const ddaf_memory_pool_t* pool,
+                                     size_t start, size_t capacity) {
+    size_t header = align_up(sizeof(ddaf_pool_slab_t), pool->alignment);
+    size_t total = header + capacity + pool->alignment;
+    char* raw = NULL;
+    size_t mapped = 0;
     
-    pool->buffer = malloc(size);
-    if (!pool->buffer) {
-        free(pool);
-        return NULL;
+#ifdef DDAF_POOL_MMAP
+    if (pool->flags & DDAF_POOL_HUGE_PAGES) {
+        total = align_up(total, DDAF_HUGE_PAGE_SIZE);
+        void* map = mmap(NULL, total, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(map, total, MADV_HUGEPAGE);
+#endif
+            raw = (char*)map;
+            mapped = total;
+        }
     }
+#endif
     
+    if (!raw) {
+        raw = (char*)ddaf_allocator_malloc(&pool->allocator, total);
+        if (!raw) return NULL;
+    }
+    
+    ddaf_pool_slab_t* slab = (ddaf_pool_slab_t*)raw;
+    uintptr_t data = align_up((uintptr_t)(raw + sizeof(ddaf_pool_slab_t)),
+                              pool->alignment);
+    slab->next = NULL;
+    slab->data = (char*)data;
+    slab->start = start;
+    slab->capacity = (size_t)(raw + total - (char*)data);
+    slab->mapped = mapped;
+    
+    return slab;
+}
+
+static void slab_destroy(const ddaf_memory_pool_t* pool,
+                         ddaf_pool_slab_t* slab) {
+#ifdef DDAF_POOL_MMAP
+    if (slab->mapped) {
+        munmap(slab, slab->mapped);
+        return;
+    }
+#endif
+    ddaf_allocator_free(&pool->allocator, slab);
+}
+
+/* Free every slab after 'slab' (nothing past the current offset is live) */
+static void slab_truncate(const ddaf_memory_pool_t* pool,
+                          ddaf_pool_slab_t* slab) {
+    ddaf_pool_slab_t* next = slab->next;
+    slab->next = NULL;
+    while (next) {
+        ddaf_pool_slab_t* victim = next;
+        next = next->next;
+        slab_destroy(pool, victim);
+    }
+}
+
+static void pool_update_totals(ddaf_memory_pool_t* pool) {
+    size_t size = 0;
+    for (ddaf_pool_slab_t* slab = pool->slabs; slab; slab = slab->next) {
+        size = slab->start + slab->capacity;
+    }
     pool->size = size;
-    pool->used = 0;
+    pool->buffer = pool->slabs ? pool->slabs->data : NULL;
+}
+
+ddaf_memory_pool_t* ddaf_create_pool(size_t size) {
+    return ddaf_create_pool_ex(size, DDAF_POOL_ALIGNMENT, 0, NULL);
+}
+
+ddaf_memory_pool_t* ddaf_create_pool_ex(size_t size, size_t alignment,
+                                        unsigned flags,
+                                        const ddaf_allocator_t* allocator) {
+    if (alignment == 0) alignment = DDAF_POOL_ALIGNMENT;
+    if (alignment & (alignment - 1)) return NULL; /* Power of two only */
+    
+    ddaf_memory_pool_t* pool = (ddaf_memory_pool_t*)
+        ddaf_allocator_malloc(allocator, sizeof(ddaf_memory_pool_t));
+    if (!pool) return NULL;
+    
+    memset(pool, 0, sizeof(ddaf_memory_pool_t));
+    if (allocator) {
+        pool->allocator = *allocator;
+    }
+    pool->alignment = alignment;
+    pool->flags = flags;
     pool->owns_buffer = true;
     
+    if (size > 0) {
+        pool->slabs = slab_create(pool, 0, size);
+        if (!pool->slabs) {
+            ddaf_allocator_free(allocator, pool);
+            return NULL;
+        }
+    }
+    pool->current = pool->slabs;
+    pool_update_totals(pool);
+    
     return pool;
 }
 
 void ddaf_destroy_pool(ddaf_memory_pool_t* pool) {
     if (!pool) return;
     
-    if (pool->owns_buffer && pool->buffer) {
-        free(pool->buffer);
+    if (pool->owns_buffer && pool->slabs) {
+        slab_truncate(pool, pool->slabs);
+        slab_destroy(pool, pool->slabs);
     }
     
-    free(pool);
+    ddaf_allocator_t allocator = pool->allocator;
+    ddaf_allocator_free(&allocator, pool);
 }
 
 void* ddaf_pool_alloc(ddaf_memory_pool_t* pool, size_t size) {
     if (!pool || size == 0) return NULL;
     
-    /* Align to 8 bytes */
-    size = (size + 7) & ~7;
+    ddaf_pool_slab_t* slab = pool->current;
+    if (slab) {
+        size_t offset = align_up(pool->used - slab->start, pool->alignment);
+        if (offset <= slab->capacity && size <= slab->capacity - offset) {
+            pool->used = slab->start + offset + size;
+            pool->high_water = DDAF_MAX(pool->high_water, pool->used);
+            return slab->data + offset;
+        }
+        
+        /* Reuse the next slab if it is big enough, else replace the tail */
+        if (slab->next && size <= slab->next->capacity) {
+            slab = slab->next;
+            pool->current = slab;
+            pool->used = slab->start + size;
+            pool->high_water = DDAF_MAX(pool->high_water, pool->used);
+            return slab->data;
+        }
+        slab_truncate(pool, slab);
+    }
+    
+    if (!pool->owns_buffer) return NULL;
+    
+    size_t start = slab ? slab->start + slab->capacity : 0;
+    size_t capacity = slab ? DDAF_MAX(size, 2 * slab->capacity) : size;
+    capacity = DDAF_MAX(capacity, DDAF_MIN_SLAB_SIZE);
     
-    if (pool->used + size > pool->size) {
-        return NULL; /* Out of memory */
+    ddaf_pool_slab_t* grown = slab_create(pool, start, capacity);
+    if (!grown) return NULL; /* Out of memory */
+    
+    if (slab) {
+        slab->next = grown;
+    } else {
+        pool->slabs = grown;
     }
+    pool->current = grown;
+    pool_update_totals(pool);
     
-    void* ptr = (char*)pool->buffer + pool->used;
-    pool->used += size;
+    pool->used = grown->start + size;
+    pool->high_water = DDAF_MAX(pool->high_water, pool->used);
     
-    return ptr;
+    return grown->data;
 }
 
 void ddaf_pool_reset(ddaf_memory_pool_t* pool) {
-    if (pool) {
-        pool->used = 0;
+    ddaf_pool_release(pool, 0);
+}
+
+size_t ddaf_pool_mark(const ddaf_memory_pool_t* pool) {
+    return pool ? pool->used : 0;
+}
+
+void ddaf_pool_release(ddaf_memory_pool_t* pool, size_t mark) {
+    if (!pool || mark > pool->used) return;
+    
+    pool->used = mark;
+    
+    /*
+     * An empty pool that grew past its first slab is merged into one slab of
+     * the combined size, so the next pass runs without crossing slabs.
+     */
+    if (mark == 0 && pool->slabs && pool->slabs->next && pool->owns_buffer) {
+        size_t total = pool->size;
+        ddaf_pool_slab_t* merged = slab_create(pool, 0, total);
+        if (merged) {
+            slab_truncate(pool, pool->slabs);
+            slab_destroy(pool, pool->slabs);
+            pool->slabs = merged;
+            pool_update_totals(pool);
+        }
+    }
+    
+    /* The frame's slab is the first one whose range contains the mark */
+    ddaf_pool_slab_t* slab = pool->slabs;
+    while (slab && slab->next && mark > slab->start + slab->capacity) {
+        slab = slab->next;
     }
+    pool->current = slab;
+}
+
+size_t ddaf_pool_high_water(const ddaf_memory_pool_t* pool) {
+    return pool ? pool->high_water : 0;
+}
+
+void ddaf_pool_bind(ddaf_memory_pool_t* pool, void* buffer, size_t size,
+                    ddaf_pool_binding_t* binding) {
+    binding->saved = *pool;
+    
+    /* The slab header lives in the binding, the data in the caller's buffer */
+    ddaf_pool_slab_t* slab = &binding->slab;
+    uintptr_t data = align_up((uintptr_t)buffer, pool->alignment);
+    size_t padding = (size_t)(data - (uintptr_t)buffer);
+    slab->next = NULL;
+    slab->data = (char*)data;
+    slab->start = 0;
+    slab->capacity = (buffer && size > padding) ? size - padding : 0;
+    slab->mapped = 0;
+    
+    pool->slabs = slab;
+    pool->current = slab;
+    pool->used = 0;
+    pool->high_water = 0;
+    pool->owns_buffer = false;
+    pool_update_totals(pool);
+}
+
+void ddaf_pool_unbind(ddaf_memory_pool_t* pool,
+                      const ddaf_pool_binding_t* binding) {
+    *pool = binding->saved;
 }
@@ -11,90 +11,469 @@
 #include <string.h>
 #include <math.h>
 
-static int online_forward(ddaf_context_t* ctx, const float* input,
-                          float* output, size_t size) {
-    ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
-    if (!params) return -1;
+/*
+ * Recompute the window sums from the buffer. Called once every buffer_size
+ * updates so the rounding drift of the incremental updates stays bounded.
+ */
+static void online_rebase(ddaf_online_params_t* params) {
+    double sum = 0.0;
+    double sumsq = 0.0;
     
-    /* Update online statistics */
-    for (size_t i = 0; i < size; i++) {
-        float value = input[i];
+    for (size_t i = 0; i < params->buffer_size; i++) {
+        double value = params->buffer[i];
+        sum += value;
+        sumsq += value * value;
+    }
+    
+    params->window_sum = sum;
+    params->window_sumsq = sumsq;
+    params->since_rebase = 0;
+}
+
+/* Net change of the window sums when old[0..n) is overwritten by input */
+static void window_delta(const float* old, const float* input, size_t n,
+                         double* delta_sum, double* delta_sumsq) {
+    double sum = 0.0;
+    double sumsq = 0.0;
+    
+    for (size_t i = 0; i < n; i++) {
+        double value = input[i];
+        double evicted = old[i];
+        sum += value - evicted;
+        sumsq += value * value - evicted * evicted;
+    }
+    
+    *delta_sum += sum;
+    *delta_sumsq += sumsq;
+}
+
+/*
+ * Push a chunk into the ring buffer. Only the last buffer_size samples can
+ * survive, and they land in at most two contiguous segments.
+ */
+static void online_push(ddaf_online_params_t* params, const float* input,
+                        size_t size) {
+    size_t capacity = params->buffer_size;
+    size_t count = DDAF_MIN(size, capacity);
+    const float* src = input + (size - count);
+    size_t pos = (params->buffer_idx + (size - count)) % capacity;
+    size_t first = DDAF_MIN(count, capacity - pos);
+    size_t second = count - first;
+    
+    double delta_sum = 0.0;
+    double delta_sumsq = 0.0;
+    if (count < capacity) {
+        window_delta(params->buffer + pos, src, first, &delta_sum, &delta_sumsq);
+        window_delta(params->buffer, src + first, second,
+                     &delta_sum, &delta_sumsq);
+    }
+    
+    memcpy(params->buffer + pos, src, first * sizeof(float));
+    memcpy(params->buffer, src + first, second * sizeof(float));
+    params->buffer_idx = (pos + count) % capacity;
+    
+    params->window_sum += delta_sum;
+    params->window_sumsq += delta_sumsq;
+    params->since_rebase += count;
+    if (params->since_rebase >= capacity) {
+        online_rebase(params);
+    }
+}
+
+/*
+ * Exponential moving mean and variance over a chunk. With f the forgetting
+ * factor and g = 1 - f, eight steps of m' = f * m + g * x unroll to
+ *   m_j = f^(j+1) * m + sum_{k<=j} g * f^(j-k) * x_k
+ * so the intermediate means come from one small lower-triangular product
+ * instead of a serial chain, and the variance recursion collapses the same
+ * way. The remainder uses the per-sample recursion. diff_sum accumulates
+ * the deviations x_j - m_j for the chunk combine below.
+ */
+static void ema_sweep(float f, const float* input, size_t size, float* mean_io,
+                      float* var_io, double* diff_sum) {
+    float g = 1.0f - f;
+    float lag[DDAF_EMA_BLOCK];                    /* g * f^j */
+    float decay[DDAF_EMA_BLOCK];                  /* f^(j+1) */
+    float weight[DDAF_EMA_BLOCK][DDAF_EMA_BLOCK]; /* g * f^(j-k), k <= j */
+    
+    float power = 1.0f;
+    for (size_t j = 0; j < DDAF_EMA_BLOCK; j++) {
+        lag[j] = g * power;
+        power *= f;
+        decay[j] = power;
+    }
+    for (size_t j = 0; j < DDAF_EMA_BLOCK; j++) {
+        for (size_t k = 0; k < DDAF_EMA_BLOCK; k++) {
+            weight[j][k] = (k <= j) ? lag[j - k] : 0.0f;
+        }
+    }
+    
+    float mean = *mean_io;
+    float var = *var_io;
+    double diffs = *diff_sum;
+    size_t i = 0;
+    
+    for (; i + DDAF_EMA_BLOCK <= size; i += DDAF_EMA_BLOCK) {
+        const float* x = input + i;
+        float means[DDAF_EMA_BLOCK];
+        float sq[DDAF_EMA_BLOCK];
+        float block_diffs = 0.0f;
         
-        /* Update buffer */
-        params->buffer[params->buffer_idx] = value;
-        params->buffer_idx = (params->buffer_idx + 1) % params->buffer_size;
+        for (size_t j = 0; j < DDAF_EMA_BLOCK; j++) {
+            float m = decay[j] * mean;
+            for (size_t k = 0; k < DDAF_EMA_BLOCK; k++) {
+                m += weight[j][k] * x[k];
+            }
+            means[j] = m;
+        }
         
-        /* Update online mean and variance */
-        if (params->online_stats) {
-            float old_mean = params->online_stats[0];
-            float old_var = params->online_stats[1];
-            
-            /* Exponential moving average */
-            params->online_stats[0] = params->forgetting_factor * old_mean + 
-                                      (1.0f - params->forgetting_factor) * value;
-            
-            float diff = value - params->online_stats[0];
-            params->online_stats[1] = params->forgetting_factor * old_var + 
-                                      (1.0f - params->forgetting_factor) * diff * diff;
+        for (size_t j = 0; j < DDAF_EMA_BLOCK; j++) {
+            float diff = x[j] - means[j];
+            sq[j] = diff * diff;
+            block_diffs += diff;
         }
+        
+        float v = decay[DDAF_EMA_BLOCK - 1] * var;
+        for (size_t k = 0; k < DDAF_EMA_BLOCK; k++) {
+            v += weight[DDAF_EMA_BLOCK - 1][k] * sq[k];
+        }
+        
+        mean = means[DDAF_EMA_BLOCK - 1];
+        var = v;
+        diffs += block_diffs;
     }
     
-    /* Compute current statistics from buffer */
-    float mean = 0.0f;
-    for (size_t i = 0; i < params->buffer_size; i++) {
-        mean += params->buffer[i];
+    for (; i < size; i++) {
+        mean = f * mean + g * input[i];
+        float diff = input[i] - mean;
+        var = f * var + g * diff * diff;
+        diffs += diff;
     }
-    mean /= params->buffer_size;
     
-    float variance = 0.0f;
-    for (size_t i = 0; i < params->buffer_size; i++) {
-        float diff = params->buffer[i] - mean;
-        variance += diff * diff;
+    *mean_io = mean;
+    *var_io = var;
+    *diff_sum = diffs;
+}
+
+/*
+ * A chunk swept from zero state: its end mean mu, end variance a and
+ * deviation sum s. Since each m_j is m0 * f^(j+1) plus the zero-state
+ * value, a chunk of L samples maps the state (m0, v0) to
+ *   m = f^L * m0 + mu
+ *   v = f^L * v0 + a - 2 * m0 * g * f^L * s + m0^2 * f^(L+1) * (1 - f^L)
+ */
+typedef struct {
+    float mean;
+    float var;
+    double diff_sum;
+} ema_chunk_t;
+
+typedef struct {
+    float f;
+    const float* input;
+    const uint16_t* input16;
+    ddaf_dtype_t dtype;
+    ema_chunk_t* chunks;
+} ema_task_t;
+
+static void ema_chunk_task(void* arg, size_t begin, size_t end) {
+    ema_task_t* task = (ema_task_t*)arg;
+    ema_chunk_t* chunk = &task->chunks[begin / DDAF_PARALLEL_GRAIN];
+    chunk->mean = 0.0f;
+    chunk->var = 0.0f;
+    chunk->diff_sum = 0.0;
+    
+    if (!task->input16) {
+        ema_sweep(task->f, task->input + begin, end - begin, &chunk->mean,
+                  &chunk->var, &chunk->diff_sum);
+        return;
     }
-    variance /= params->buffer_size;
-    float stddev = sqrtf(variance + DDAF_EPSILON);
     
-    /* Apply online activation */
-    for (size_t i = 0; i < size; i++) {
-        float normalized = (input[i] - mean) / (stddev + DDAF_EPSILON);
+    float block[DDAF_KERNEL_BLOCK];
+    for (size_t start = begin; start < end; start += DDAF_KERNEL_BLOCK) {
+        size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, end - start);
+        ddaf_widen(task->dtype, task->input16 + start, block, n);
+        ema_sweep(task->f, block, n, &chunk->mean, &chunk->var,
+                  &chunk->diff_sum);
+    }
+}
+
+/*
+ * Two levels for inputs over one chunk: chunks sweep from zero state in
+ * parallel and are applied to the running state in order, so the result
+ * is the same for every thread count.
+ */
+static void ema_chunked(ddaf_online_params_t* params, ema_task_t* task,
+                        size_t size) {
+    double f = task->f;
+    double g = 1.0 - f;
+    double mean = params->online_stats[0];
+    double var = params->online_stats[1];
+    ema_chunk_t chunks[DDAF_PARALLEL_ROUND];
+    const size_t round = (size_t)DDAF_PARALLEL_ROUND * DDAF_PARALLEL_GRAIN;
+    ema_task_t part = *task;
+    part.chunks = chunks;
+    
+    for (size_t start = 0; start < size; start += round) {
+        size_t count = DDAF_MIN(round, size - start);
+        size_t n_chunks = (count + DDAF_PARALLEL_GRAIN - 1) / DDAF_PARALLEL_GRAIN;
+        part.input = task->input ? task->input + start : NULL;
+        part.input16 = task->input16 ? task->input16 + start : NULL;
+        ddaf_parallel_for(count, DDAF_PARALLEL_GRAIN, ema_chunk_task, &part);
         
+        for (size_t c = 0; c < n_chunks; c++) {
+            size_t length = DDAF_MIN(DDAF_PARALLEL_GRAIN,
+                                     count - c * DDAF_PARALLEL_GRAIN);
+            double decay = pow(f, (double)length);
+            
+            var = decay * var + chunks[c].var -
+                  2.0 * mean * g * decay * chunks[c].diff_sum +
+                  mean * mean * decay * f * (1.0 - decay);
+            mean = decay * mean + chunks[c].mean;
+        }
+    }
+    
+    params->online_stats[0] = (float)mean;
+    params->online_stats[1] = (float)var;
+}
+
+static void online_ema(ddaf_online_params_t* params, const float* input,
+                       size_t size) {
+    if (!params->online_stats) return;
+    
+    if (size > DDAF_PARALLEL_GRAIN) {
+        ema_task_t task = { params->forgetting_factor, input, NULL,
+                            DDAF_DTYPE_F16, NULL };
+        ema_chunked(params, &task, size);
+        return;
+    }
+    
+    double diff_sum = 0.0;
+    ema_sweep(params->forgetting_factor, input, size, &params->online_stats[0],
+              &params->online_stats[1], &diff_sum);
+}
+
+/* Window mean and deviation from the running sums */
+static void online_window(const ddaf_online_params_t* params, float* mean,
+                          float* stddev) {
+    double window_mean = params->window_sum / (double)params->buffer_size;
+    double window_var = params->window_sumsq / (double)params->buffer_size -
+                        window_mean * window_mean;
+    float variance = (float)DDAF_MAX(window_var, 0.0);
+    
+    *mean = (float)window_mean;
+    *stddev = sqrtf(variance + DDAF_EPSILON);
+}
+
+/* Window and moving-average statistics shared by every block of a call */
+typedef struct {
+    const ddaf_context_t* ctx;
+    float mean;
+    float stddev;
+    bool global;                    /* Moving average kept */
+    float global_mean;
+    float global_std;
+} online_call_t;
+
+/* Statistics as they stand after the last update */
+static void online_call(const ddaf_context_t* ctx, online_call_t* call) {
+    const ddaf_online_params_t* params =
+        (const ddaf_online_params_t*)ctx->params;
+    
+    call->ctx = ctx;
+    online_window(params, &call->mean, &call->stddev);
+    call->global = params->online_stats != NULL;
+    call->global_mean = call->global ? params->online_stats[0] : 0.0f;
+    call->global_std = call->global ?
+                       sqrtf(params->online_stats[1] + DDAF_EPSILON) : 1.0f;
+}
+
+/* Activate n elements against the window statistics; output may be input */
+static void online_block(void* arg, const float* input, float* output,
+                         size_t start, size_t n) {
+    const online_call_t* call = (const online_call_t*)arg;
+    const ddaf_context_t* ctx = call->ctx;
+    float mean = call->mean;
+    float stddev = call->stddev;
+    (void)start;
+    const ddaf_kernel_table_t* kernels = ddaf_get_kernels(ctx->precision);
+    
+    /* Frozen inference: interpolate the baked GELU */
+    const ddaf_baked_t* baked = (const ddaf_baked_t*)ctx->baked;
+    float normalized[DDAF_KERNEL_BLOCK];
+    float activated[DDAF_KERNEL_BLOCK];
+    
+    for (size_t j = 0; j < n; j++) {
+        normalized[j] = (input[j] - mean) / (stddev + DDAF_EPSILON);
+    }
+    
+    if (baked) {
+        kernels->lut(&baked->gelu, normalized, activated, n);
+    } else {
+        kernels->gelu(normalized, activated, n);
+    }
+    
+    for (size_t j = 0; j < n; j++) {
         /* Online adaptive activation */
         float online_factor = 1.0f;
-        if (params->online_stats) {
-            float global_mean = params->online_stats[0];
-            float global_std = sqrtf(params->online_stats[1] + DDAF_EPSILON);
-            online_factor = 1.0f + 0.1f * (normalized - (input[i] - global_mean) / 
-                                          (global_std + DDAF_EPSILON));
+        if (call->global) {
+            online_factor = 1.0f + 0.1f * (normalized[j] - (input[j] - call->global_mean) / 
+                                          (call->global_std + DDAF_EPSILON));
         }
         
-        output[i] = online_factor * ddaf_gelu(normalized);
+        output[j] = online_factor * activated[j];
     }
+}
+
+static int online_forward(ddaf_context_t* ctx, const float* input,
+                          float* output, size_t size) {
+    ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
+    if (!params) return -1;
+    
+    /* Update online statistics */
+    if (!ctx->replay) {
+        online_push(params, input, size);
+        online_ema(params, input, size);
+    }
+    
+    online_call_t call;
+    online_call(ctx, &call);
+    
+    /* Apply online activation in cache-resident blocks */
+    ddaf_parallel_sweep(size, online_block, &call, input, output);
     
     return 0;
 }
 
-static int online_backward(ddaf_context_t* ctx, const float* grad_output,
-                           float* grad_input, size_t size) {
+/*
+ * 16-bit storage: a first sweep feeds the statistics block by block (only
+ * the last buffer_size samples reach the ring buffer), a second activates.
+ * Inputs over one chunk leave the moving average to the chunked pass, and
+ * the first sweep then only covers the samples the buffer keeps.
+ */
+static int online_forward16(ddaf_context_t* ctx, const uint16_t* input,
+                            uint16_t* output, size_t size,
+                            ddaf_dtype_t dtype) {
     ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
     if (!params) return -1;
     
-    /* Compute gradient through online activation */
-    for (size_t i = 0; i < size; i++) {
+    float block[DDAF_KERNEL_BLOCK];
+    size_t kept = size > params->buffer_size ? size - params->buffer_size : 0;
+    bool chunked = size > DDAF_PARALLEL_GRAIN;
+    size_t first = chunked ? kept - kept % DDAF_KERNEL_BLOCK : 0;
+    
+    if (!ctx->replay) {
+        for (size_t start = first; start < size; start += DDAF_KERNEL_BLOCK) {
+            size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, size - start);
+            ddaf_widen(dtype, input + start, block, n);
+            
+            if (start + n > kept) {
+                size_t skip = kept > start ? kept - start : 0;
+                online_push(params, block + skip, n - skip);
+            }
+            if (!chunked) online_ema(params, block, n);
+        }
+        
+        if (chunked && params->online_stats) {
+            ema_task_t task = { params->forgetting_factor, NULL, input, dtype,
+                                NULL };
+            ema_chunked(params, &task, size);
+        }
+    }
+    
+    online_call_t call;
+    online_call(ctx, &call);
+    ddaf_parallel_sweep16(size, online_block, &call, input, output, dtype);
+    
+    return 0;
+}
+
+/*
+ * Shared statistics take the batch as one stream, the flat pass. Per
+ * sample, each sample updates the statistics in turn and is activated
+ * against them, as in a loop over samples; only the activation sweeps
+ * run after all the updates.
+ */
+static int online_forward_batched(ddaf_context_t* ctx, const float* input,
+                                  float* output, size_t batch,
+                                  size_t sample_size, unsigned flags) {
+    ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
+    if (!params) return -1;
+    
+    if (!(flags & DDAF_BATCH_PER_SAMPLE)) {
+        return online_forward(ctx, input, output, batch * sample_size);
+    }
+    
+    online_call_t* calls = (online_call_t*)ddaf_pool_alloc(ctx->pool,
+                                                            batch * sizeof(online_call_t));
+    if (!calls) return -1;
+    
+    for (size_t b = 0; b < batch; b++) {
+        const float* sample = input + b * sample_size;
+        if (!ctx->replay) {
+            online_push(params, sample, sample_size);
+            online_ema(params, sample, sample_size);
+        }
+        online_call(ctx, &calls[b]);
+    }
+    
+    ddaf_parallel_sweep_batched(batch, sample_size, online_block, calls,
+                                sizeof(online_call_t), input, output);
+    return 0;
+}
+
+typedef struct {
+    const ddaf_online_params_t* params;
+    const float* input;             /* Saved forward input, or NULL */
+    const float* grad_output;
+    float* grad_input;
+} online_grad_t;
+
+/* Gradient of elements [begin, end) */
+static void online_backward_task(void* arg, size_t begin, size_t end) {
+    const online_grad_t* grad = (const online_grad_t*)arg;
+    const ddaf_online_params_t* params = grad->params;
+    const float* input = grad->input;
+    
+    for (size_t i = begin; i < end; i++) {
         float online_factor = 1.0f;
         if (params->online_stats) {
             float global_mean = params->online_stats[0];
             float global_std = sqrtf(params->online_stats[1] + DDAF_EPSILON);
-            float normalized = (params->buffer[i] - global_mean) / 
+            float sample = input ? input[i] :
+                                   params->buffer[i % params->buffer_size];
+            float normalized = (sample - global_mean) / 
                                (global_std + DDAF_EPSILON);
             online_factor = 1.0f + 0.1f * normalized;
         }
         
-        grad_input[i] = grad_output[i] * online_factor;
+        grad->grad_input[i] = grad->grad_output[i] * online_factor;
     }
+}
+
+static int online_backward(ddaf_context_t* ctx, const float* grad_output,
+                           float* grad_input, size_t size) {
+    ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
+    if (!params) return -1;
+    
+    /* The forward input when one was kept, else the ring buffer's samples */
+    online_grad_t grad = { params, ddaf_saved_input(ctx, size), grad_output,
+                           grad_input };
+    
+    /* Compute gradient through online activation */
+    ddaf_parallel_for(size, DDAF_PARALLEL_GRAIN, online_backward_task, &grad);
     
     return 0;
 }
 
+static void online_relocate(ddaf_context_t* ctx,
+                            const ddaf_relocation_t* reloc) {
+    ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
+    
+    params->online_stats = ddaf_relocate_ptr(reloc, params->online_stats);
+    params->buffer = ddaf_relocate_ptr(reloc, params->buffer);
+}
+
 int ddaf_init_online(ddaf_context_t* ctx, size_t buffer_size) {
     if (!ctx) return -1;
     
@@ -102,11 +481,8 @@ int ddaf_init_online(ddaf_context_t* ctx, size_t buffer_size) {
                         buffer_size * sizeof(float) + /* buffer */
                         2 * sizeof(float); /* online_stats */
     
-    if (ctx->params) {
-        free(ctx->params);
-    }
-    
-    ctx->params = calloc(1, param_size);
+    ddaf_unbake(ctx);
+    ctx->params = ddaf_alloc_params(ctx, param_size);
     if (!ctx->params) return -1;
     
     ddaf_online_params_t* params = (ddaf_online_params_t*)ctx->params;
@@ -125,9 +501,17 @@ int ddaf_init_online(ddaf_context_t* ctx, size_t buffer_size) {
     for (size_t i = 0; i < buffer_size; i++) {
         params->buffer[i] = 0.0f;
     }
+    params->window_sum = 0.0;
+    params->window_sumsq = 0.0;
+    params->since_rebase = 0;
     
     ctx->forward = online_forward;
+    ctx->forward16 = online_forward16;
     ctx->backward = online_backward;
+    ctx->forward_batched = online_forward_batched;
+    ctx->backward_batched = ddaf_batch_backward_flat;
+    ctx->relocate = online_relocate;
+    ctx->backward_workspace = ddaf_saved_input_workspace;
     
     return 0;
 }
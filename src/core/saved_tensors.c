@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Saved forward inputs for the backward pass
+ * Float or half-precision copies, or recomputation from a checkpoint,
+ * chosen per context or against a memory budget
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+static ddaf_context_t* tree_root(ddaf_context_t* ctx) {
+    while (ctx->parent) {
+        ctx = ctx->parent;
+    }
+    return ctx;
+}
+
+static size_t saved_size(ddaf_save_policy_t as, size_t count) {
+    switch (as) {
+        case DDAF_SAVE_INPUT:
+            return count * sizeof(float);
+        case DDAF_SAVE_FP16:
+            return count * sizeof(uint16_t);
+        default:
+            return 0;
+    }
+}
+
+/* Leaves use their input; architectures only as a checkpoint for children */
+static bool needs_input(const ddaf_context_t* ctx) {
+    return !ctx->first_child || ctx->recompute;
+}
+
+/* The parent kept its input this step and can derive ctx's from it */
+static bool can_recompute(const ddaf_context_t* ctx) {
+    const ddaf_context_t* parent = ctx->parent;
+    return parent && parent->recompute && parent->saved_as != DDAF_SAVE_NONE;
+}
+
+static ddaf_save_policy_t resolve_policy(const ddaf_context_t* ctx,
+                                         const ddaf_context_t* root,
+                                         size_t size) {
+    ddaf_save_policy_t policy = ctx->save_policy;
+    
+    if (policy == DDAF_SAVE_NONE || !needs_input(ctx)) return DDAF_SAVE_NONE;
+    if (policy == DDAF_SAVE_INPUT || policy == DDAF_SAVE_FP16) return policy;
+    if (can_recompute(ctx)) return DDAF_SAVE_RECOMPUTE;
+    
+    /* Nothing to rebuild from: this context becomes the checkpoint */
+    if (policy == DDAF_SAVE_RECOMPUTE) return DDAF_SAVE_INPUT;
+    
+    size_t left = root->memory_budget > root->memory_used ?
+                  root->memory_budget - root->memory_used : 0;
+    if (saved_size(DDAF_SAVE_INPUT, size) <= left) return DDAF_SAVE_INPUT;
+    if (saved_size(DDAF_SAVE_FP16, size) <= left) return DDAF_SAVE_FP16;
+    return DDAF_SAVE_NONE;
+}
+
+/* Resolve this call's policy and make room; returns the bytes to fill */
+static size_t prepare_save(ddaf_context_t* ctx, size_t size) {
+    ddaf_context_t* root = tree_root(ctx);
+    
+    /* Each call on the root starts a new step */
+    if (ctx == root) root->memory_used = 0;
+    
+    ddaf_save_policy_t as = resolve_policy(ctx, root, size);
+    size_t bytes = saved_size(as, size);
+    
+    /* Grow on demand; drop the block once nothing needs to be kept */
+    if (bytes > ctx->saved_capacity || (bytes == 0 && ctx->saved)) {
+        ddaf_ctx_free(ctx, ctx->saved);
+        ctx->saved = bytes ? ddaf_ctx_alloc(ctx, bytes) : NULL;
+        ctx->saved_capacity = ctx->saved ? bytes : 0;
+        if (bytes && !ctx->saved) {
+            as = DDAF_SAVE_NONE;
+            bytes = 0;
+        }
+    }
+    
+    ctx->saved_as = as;
+    ctx->saved_count = size;
+    root->memory_used += bytes;
+    return bytes;
+}
+
+void ddaf_save_input(ddaf_context_t* ctx, const float* input, size_t size) {
+    if (prepare_save(ctx, size) == 0) return;
+    
+    if (ctx->saved_as == DDAF_SAVE_INPUT) {
+        memcpy(ctx->saved, input, size * sizeof(float));
+    } else {
+        ddaf_narrow(DDAF_DTYPE_F16, input, (uint16_t*)ctx->saved, size);
+    }
+}
+
+void ddaf_save_input16(ddaf_context_t* ctx, const uint16_t* input,
+                       size_t size, ddaf_dtype_t dtype) {
+    if (prepare_save(ctx, size) == 0) return;
+    
+    if (ctx->saved_as == DDAF_SAVE_INPUT) {
+        ddaf_widen(dtype, input, (float*)ctx->saved, size);
+    } else if (dtype == DDAF_DTYPE_F16) {
+        memcpy(ctx->saved, input, size * sizeof(uint16_t));
+    } else {
+        /* bf16 to fp16 through float, a block at a time */
+        float block[DDAF_KERNEL_BLOCK];
+        uint16_t* half = (uint16_t*)ctx->saved;
+        for (size_t start = 0; start < size; start += DDAF_KERNEL_BLOCK) {
+            size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, size - start);
+            ddaf_widen(dtype, input + start, block, n);
+            ddaf_narrow(DDAF_DTYPE_F16, block, half + start, n);
+        }
+    }
+}
+
+const float* ddaf_saved_input(ddaf_context_t* ctx, size_t size) {
+    if (!ctx || size > ctx->saved_count) return NULL;
+    
+    float* input;
+    switch (ctx->saved_as) {
+        case DDAF_SAVE_INPUT:
+            return (const float*)ctx->saved;
+        
+        case DDAF_SAVE_FP16:
+            input = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
+            if (!input) return NULL;
+        
+            ddaf_widen(DDAF_DTYPE_F16, (const uint16_t*)ctx->saved, input,
+                       size);
+            return input;
+        
+        case DDAF_SAVE_RECOMPUTE:
+            input = (float*)ddaf_pool_alloc(ctx->pool, size * sizeof(float));
+            if (!input) return NULL;
+            if (ctx->parent->recompute(ctx->parent, ctx, input, size) != 0) {
+                return NULL;
+            }
+            return input;
+        
+        default:
+            return NULL;
+    }
+}
+
+void ddaf_discard_saved(ddaf_context_t* ctx) {
+    ctx->saved_as = DDAF_SAVE_NONE;
+}
+
+/* Decoded or rebuilt input, plus what the ancestors take to produce theirs */
+size_t ddaf_saved_input_workspace(const ddaf_context_t* ctx, size_t size) {
+    switch (ctx->save_policy) {
+        case DDAF_SAVE_NONE:
+        case DDAF_SAVE_INPUT:
+            return 0;
+        case DDAF_SAVE_FP16:
+            return ddaf_workspace_floats(ctx, size);
+        default:
+            return ddaf_workspace_floats(ctx, size) +
+                   (ctx->parent ? ddaf_saved_input_workspace(ctx->parent, size)
+                                : 0);
+    }
+}
+
+int ddaf_recompute_passthrough(ddaf_context_t* ctx, const ddaf_context_t* child,
+                               float* input, size_t size) {
+    (void)child;
+    
+    const float* saved = ddaf_saved_input(ctx, size);
+    if (!saved) return -1;
+    
+    memcpy(input, saved, size * sizeof(float));
+    return 0;
+}
+
+int ddaf_replay_forward(ddaf_context_t* ctx, const float* input, float* output,
+                        size_t size) {
+    if (!ctx || !ctx->forward) return -1;
+    
+    size_t mark = ddaf_pool_mark(ctx->pool);
+    ctx->replay = true;
+    int ret = ctx->batch > 1 && ctx->forward_batched ?
+              ctx->forward_batched(ctx, input, output, ctx->batch,
+                                   size / ctx->batch, ctx->batch_flags) :
+              ctx->forward(ctx, input, output, size);
+    ctx->replay = false;
+    ddaf_pool_release(ctx->pool, mark);
+    
+    return ret;
+}
+
+int ddaf_set_save_policy(ddaf_context_t* ctx, ddaf_save_policy_t policy) {
+    if (!ctx) return -1;
+    if ((unsigned)policy > DDAF_SAVE_AUTO) return -1;
+    
+    ctx->save_policy = policy;
+    for (ddaf_context_t* child = ctx->first_child; child;
+         child = child->next_sibling) {
+        ddaf_set_save_policy(child, policy);
+    }
+    
+    return 0;
+}
+
+int ddaf_set_memory_budget(ddaf_context_t* ctx, size_t bytes) {
+    if (!ctx || ctx->parent) return -1;
+    
+    ctx->memory_budget = bytes;
+    return ddaf_set_save_policy(ctx, DDAF_SAVE_AUTO);
+}
+
+size_t ddaf_saved_bytes(const ddaf_context_t* ctx) {
+    if (!ctx) return 0;
+    
+    size_t bytes = saved_size(ctx->saved_as, ctx->saved_count);
+    for (const ddaf_context_t* child = ctx->first_child; child;
+         child = child->next_sibling) {
+        bytes += ddaf_saved_bytes(child);
+    }
+    return bytes;
+}
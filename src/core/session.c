@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Inference sessions
+ * A session mirrors a model's context tree: each mirrored context owns the
+ * leading state bytes of its params block and shares the rest, and the
+ * baked tables, with the model
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct ddaf_session {
+    ddaf_context_t** nodes;         /* Depth-first, the root first */
+    ddaf_context_t** models;        /* Model context of each node */
+    size_t count;
+    ddaf_moved_block_t* blocks;     /* Model struct or state -> session */
+    ddaf_relocation_t reloc;
+    ddaf_allocator_t allocator;
+};
+
+static size_t state_bytes(const ddaf_context_t* model) {
+    if (!model->params) return 0;
+    return model->state_size ? model->state_size(model) : model->params_size;
+}
+
+static void add_block(ddaf_session_t* session, const void* old, size_t size,
+                      void* new_base) {
+    ddaf_moved_block_t* block = &session->blocks[session->reloc.count++];
+    block->old_base = (const char*)old;
+    block->size = size;
+    block->new_base = (char*)new_base;
+}
+
+/* Copy the model's state, then let each type re-point its own params */
+static void load_state(ddaf_session_t* session) {
+    for (size_t i = 0; i < session->count; i++) {
+        ddaf_context_t* node = session->nodes[i];
+        if (node->params) {
+            memcpy(node->params, session->models[i]->params,
+                   node->params_size);
+        }
+    }
+    
+    for (size_t i = 0; i < session->count; i++) {
+        ddaf_context_t* node = session->nodes[i];
+        if (node->params && node->relocate) {
+            node->relocate(node, &session->reloc);
+        }
+    }
+}
+
+/* A model context without its per-call state, on the session's pool */
+static ddaf_context_t* mirror(ddaf_session_t* session,
+                             const ddaf_context_t* model,
+                             ddaf_memory_pool_t* pool) {
+    ddaf_context_t* node = (ddaf_context_t*)
+        ddaf_allocator_malloc(&session->allocator, sizeof(ddaf_context_t));
+    if (!node) return NULL;
+    
+    *node = *model;
+    node->pool = pool;
+    node->owns_pool = false;
+    node->params = NULL;
+    node->params_size = 0;
+    node->arena = NULL;
+    node->arena_size = 0;
+    node->saved = NULL;
+    node->saved_as = DDAF_SAVE_NONE;
+    node->saved_count = 0;
+    node->saved_capacity = 0;
+    node->memory_used = 0;
+    node->replay = false;
+    node->batch = 1;
+    node->batch_state = NULL;
+    node->batch_state_size = 0;
+    add_block(session, model, sizeof(ddaf_context_t), node);
+    
+    size_t bytes = state_bytes(model);
+    if (bytes > 0) {
+        node->params = ddaf_ctx_alloc(node, bytes);
+        if (!node->params) {
+            ddaf_allocator_free(&session->allocator, node);
+            return NULL;
+        }
+        node->params_size = bytes;
+        add_block(session, model->params, bytes, node->params);
+    }
+    
+    return node;
+}
+
+ddaf_session_t* ddaf_create_session(const ddaf_context_t* model) {
+    if (!model || model->parent) return NULL;
+    
+    /* Sessions read the kernel tables; select them before any call runs */
+    ddaf_get_isa();
+    
+    const ddaf_allocator_t* allocator = &model->options.allocator;
+    ddaf_session_t* session = (ddaf_session_t*)
+        ddaf_allocator_malloc(allocator, sizeof(ddaf_session_t));
+    if (!session) return NULL;
+    memset(session, 0, sizeof(ddaf_session_t));
+    session->allocator = *allocator;
+    
+    /* Up to two blocks per context: struct and state */
+    size_t count = ddaf_tree_count(model);
+    session->nodes = (ddaf_context_t**)
+        ddaf_allocator_malloc(allocator, count * sizeof(ddaf_context_t*));
+    session->models = (ddaf_context_t**)
+        ddaf_allocator_malloc(allocator, count * sizeof(ddaf_context_t*));
+    session->blocks = (ddaf_moved_block_t*)
+        ddaf_allocator_malloc(allocator,
+                              2 * count * sizeof(ddaf_moved_block_t));
+    ddaf_memory_pool_t* pool = ddaf_create_pool_ex(model->options.pool_size,
+                                                   model->options.alignment,
+                                                   model->options.pool_flags,
+                                                   allocator);
+    if (!session->nodes || !session->models || !session->blocks || !pool) {
+        ddaf_destroy_pool(pool);
+        ddaf_destroy_session(session);
+        return NULL;
+    }
+    session->reloc.blocks = session->blocks;
+    ddaf_tree_collect((ddaf_context_t*)model, session->models, 0);
+    
+    for (size_t i = 0; i < count; i++) {
+        ddaf_context_t* node = mirror(session, session->models[i], pool);
+        if (!node) {
+            if (i == 0) ddaf_destroy_pool(pool);
+            ddaf_destroy_session(session);
+            return NULL;
+        }
+        node->owns_pool = (i == 0);
+        session->nodes[session->count++] = node;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        ddaf_context_t* node = session->nodes[i];
+        node->parent = ddaf_relocate_ptr(&session->reloc, node->parent);
+        node->first_child = ddaf_relocate_ptr(&session->reloc,
+                                              node->first_child);
+        node->next_sibling = ddaf_relocate_ptr(&session->reloc,
+                                               node->next_sibling);
+    }
+    load_state(session);
+    
+    return session;
+}
+
+void ddaf_destroy_session(ddaf_session_t* session) {
+    if (!session) return;
+    
+    /* Session blocks never live in an arena; baked tables are the model's */
+    const ddaf_allocator_t* allocator = &session->allocator;
+    for (size_t i = 0; i < session->count; i++) {
+        ddaf_context_t* node = session->nodes[i];
+        ddaf_allocator_free(allocator, node->params);
+        ddaf_allocator_free(allocator, node->saved);
+        ddaf_allocator_free(allocator, node->batch_state);
+        if (node->owns_pool) {
+            ddaf_destroy_pool(node->pool);
+        }
+        ddaf_allocator_free(allocator, node);
+    }
+    
+    ddaf_allocator_free(allocator, session->nodes);
+    ddaf_allocator_free(allocator, session->models);
+    ddaf_allocator_free(allocator, session->blocks);
+    ddaf_allocator_free(allocator, session);
+}
+
+void ddaf_reset_session(ddaf_session_t* session) {
+    if (!session) return;
+    
+    for (size_t i = 0; i < session->count; i++) {
+        ddaf_context_t* node = session->nodes[i];
+        ddaf_ctx_free(node, node->batch_state);
+        node->batch_state = NULL;
+        node->batch_state_size = 0;
+        node->saved_as = DDAF_SAVE_NONE;
+        node->saved_count = 0;
+    }
+    load_state(session);
+    ddaf_pool_reset(session->nodes[0]->pool);
+}
+
+int ddaf_session_forward(ddaf_session_t* session, const float* input,
+                         float* output, size_t size) {
+    if (!session) return -1;
+    return ddaf_forward(session->nodes[0], input, output, size);
+}
+
+int ddaf_session_backward(ddaf_session_t* session, const float* grad_output,
+                          float* grad_input, size_t size) {
+    if (!session) return -1;
+    return ddaf_backward(session->nodes[0], grad_output, grad_input, size);
+}
+
+int ddaf_session_forward_batched(ddaf_session_t* session, const float* input,
+                                 float* output, size_t batch,
+                                 size_t sample_size, unsigned flags) {
+    if (!session) return -1;
+    return ddaf_forward_batched(session->nodes[0], input, output, batch,
+                                sample_size, flags);
+}
+
+int ddaf_session_backward_batched(ddaf_session_t* session,
+                                  const float* grad_output, float* grad_input,
+                                  size_t batch, size_t sample_size,
+                                  unsigned flags) {
+    if (!session) return -1;
+    return ddaf_backward_batched(session->nodes[0], grad_output, grad_input,
+                                 batch, sample_size, flags);
+}
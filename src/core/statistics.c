@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ * 
+ * Blocked single-sweep mean/variance reduction
+ * Each block is reduced while resident in L1 and merged with Chan's
+ * parallel update, so the input is streamed from memory only once.
+ * Large inputs reduce chunk by chunk on the thread pool.
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DDAF_MOMENT_LANES 8
+
+void ddaf_moments_block(const float* x, size_t n, ddaf_moments_t* out) {
+    float sum[DDAF_MOMENT_LANES] = { 0.0f };
+    size_t i = 0;
+    
+    /* Independent lanes so the reduction vectorizes */
+    for (; i + DDAF_MOMENT_LANES <= n; i += DDAF_MOMENT_LANES) {
+        for (size_t l = 0; l < DDAF_MOMENT_LANES; l++) {
+            sum[l] += x[i + l];
+        }
+    }
+    for (; i < n; i++) {
+        sum[0] += x[i];
+    }
+    
+    float total = 0.0f;
+    for (size_t l = 0; l < DDAF_MOMENT_LANES; l++) {
+        total += sum[l];
+    }
+    float mean = n > 0 ? total / (float)n : 0.0f;
+    
+    /* Second pass over the same block hits L1 */
+    float m2[DDAF_MOMENT_LANES] = { 0.0f };
+    for (i = 0; i + DDAF_MOMENT_LANES <= n; i += DDAF_MOMENT_LANES) {
+        for (size_t l = 0; l < DDAF_MOMENT_LANES; l++) {
+            float diff = x[i + l] - mean;
+            m2[l] += diff * diff;
+        }
+    }
+    for (; i < n; i++) {
+        float diff = x[i] - mean;
+        m2[0] += diff * diff;
+    }
+    
+    float total_m2 = 0.0f;
+    for (size_t l = 0; l < DDAF_MOMENT_LANES; l++) {
+        total_m2 += m2[l];
+    }
+    
+    out->count = (double)n;
+    out->mean = mean;
+    out->m2 = total_m2;
+}
+
+void ddaf_moments_merge(ddaf_moments_t* acc, const ddaf_moments_t* other) {
+    if (other->count == 0.0) return;
+    if (acc->count == 0.0) {
+        *acc = *other;
+        return;
+    }
+    
+    double count = acc->count + other->count;
+    double delta = other->mean - acc->mean;
+    
+    acc->mean += delta * other->count / count;
+    acc->m2 += other->m2 + delta * delta * acc->count * other->count / count;
+    acc->count = count;
+}
+
+/* Chunk partials of a round, folded in chunk order by the caller */
+typedef struct {
+    const float* x;
+    const uint16_t* x16;
+    ddaf_dtype_t dtype;
+    ddaf_moments_t* partials;
+} moments_task_t;
+
+/* Blocked serial reduction; 16-bit blocks are widened on the stack */
+static void moments_serial(const moments_task_t* task, size_t begin,
+                           size_t end, ddaf_moments_t* out) {
+    ddaf_moments_t acc = { 0.0, 0.0, 0.0 };
+    float block_data[DDAF_STATS_BLOCK];
+    
+    for (size_t start = begin; start < end; start += DDAF_STATS_BLOCK) {
+        size_t count = DDAF_MIN(DDAF_STATS_BLOCK, end - start);
+        const float* data = block_data;
+        if (task->x16) {
+            ddaf_widen(task->dtype, task->x16 + start, block_data, count);
+        } else {
+            data = task->x + start;
+        }
+        
+        ddaf_moments_t block;
+        ddaf_moments_block(data, count, &block);
+        ddaf_moments_merge(&acc, &block);
+    }
+    
+    *out = acc;
+}
+
+static void moments_task(void* arg, size_t begin, size_t end) {
+    moments_task_t* task = (moments_task_t*)arg;
+    moments_serial(task, begin, end,
+                   &task->partials[begin / DDAF_PARALLEL_GRAIN]);
+}
+
+/*
+ * Two levels: chunks of DDAF_PARALLEL_GRAIN elements reduce in parallel,
+ * then their partials are merged in chunk order, so the result is the same
+ * for every thread count. One chunk is the plain blocked reduction.
+ */
+static void moments_tree(moments_task_t* task, size_t n, ddaf_moments_t* out) {
+    if (n <= DDAF_PARALLEL_GRAIN) {
+        moments_serial(task, 0, n, out);
+        return;
+    }
+    
+    ddaf_moments_t acc = { 0.0, 0.0, 0.0 };
+    ddaf_moments_t partials[DDAF_PARALLEL_ROUND];
+    const size_t round = (size_t)DDAF_PARALLEL_ROUND * DDAF_PARALLEL_GRAIN;
+    moments_task_t chunk = *task;
+    chunk.partials = partials;
+    
+    for (size_t start = 0; start < n; start += round) {
+        size_t count = DDAF_MIN(round, n - start);
+        size_t n_chunks = (count + DDAF_PARALLEL_GRAIN - 1) / DDAF_PARALLEL_GRAIN;
+        chunk.x = task->x ? task->x + start : NULL;
+        chunk.x16 = task->x16 ? task->x16 + start : NULL;
+        
+        ddaf_parallel_for(count, DDAF_PARALLEL_GRAIN, moments_task, &chunk);
+        for (size_t c = 0; c < n_chunks; c++) {
+            ddaf_moments_merge(&acc, &partials[c]);
+        }
+    }
+    
+    *out = acc;
+}
+
+void ddaf_moments_compute(const float* x, size_t n, ddaf_moments_t* out) {
+    moments_task_t task = { x, NULL, DDAF_DTYPE_F16, NULL };
+    moments_tree(&task, n, out);
+}
+
+/* Same blocking as ddaf_moments_compute, widening each block on the stack */
+void ddaf_moments_compute16(const uint16_t* x, size_t n, ddaf_dtype_t dtype,
+                            ddaf_moments_t* out) {
+    moments_task_t task = { NULL, x, dtype, NULL };
+    moments_tree(&task, n, out);
+}
+
+typedef struct {
+    const float* x;
+    size_t sample_size;
+    ddaf_moments_t* out;
+} batch_moments_t;
+
+/* Samples [begin, end); a lone sample still splits its own reduction */
+static void batch_moments_task(void* arg, size_t begin, size_t end) {
+    const batch_moments_t* task = (const batch_moments_t*)arg;
+    
+    for (size_t b = begin; b < end; b++) {
+        ddaf_moments_compute(task->x + b * task->sample_size,
+                             task->sample_size, &task->out[b]);
+    }
+}
+
+void ddaf_moments_batched(const float* x, size_t batch, size_t sample_size,
+                          ddaf_moments_t* out) {
+    if (sample_size == 0) return;
+    
+    batch_moments_t task = { x, sample_size, out };
+    size_t grain = DDAF_MAX(DDAF_PARALLEL_GRAIN / sample_size, (size_t)1);
+    ddaf_parallel_for(batch, grain, batch_moments_task, &task);
+}
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2025, Shyamal Suhana Chandra
+ *
+ * Work-stealing thread pool for large elementwise calls
+ * A call's chunks are dealt out evenly; a worker that runs dry steals the
+ * back half of another worker's remaining range. The calling thread works
+ * as worker 0, so one thread means no pool at all.
+ */
+
+#include "ddaf.h"
+#include "ddaf_internal.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Chunk range a worker owns: it takes from next, thieves from end */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} worker_queue_t;
+
+static struct {
+    pthread_mutex_t job_lock;       /* One job at a time; held by its caller */
+    pthread_mutex_t lock;           /* Job hand-off and completion */
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t threads[DDAF_MAX_THREADS];
+    worker_queue_t queues[DDAF_MAX_THREADS];
+    size_t n_threads;               /* Including the caller */
+    
+    /* Current job */
+    ddaf_task_fn fn;
+    void* arg;
+    size_t count;
+    size_t grain;
+    unsigned long generation;
+    unsigned long spawn_generation; /* Last job before the workers started */
+    size_t active;                  /* Helpers still running the job */
+    bool shutdown;
+} pool = {
+    .job_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .queues[0].lock = PTHREAD_MUTEX_INITIALIZER,
+    .n_threads = 1
+};
+
+/* Tasks run inline on workers, so a nested call never waits on the pool */
+static _Thread_local bool in_worker = false;
+static _Thread_local size_t worker_index = 0;
+
+static bool take_own(worker_queue_t* queue, size_t* chunk) {
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->next < queue->end;
+    if (found) *chunk = queue->next++;
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+/* Move the back half of the fullest-looking victim's range to self */
+static bool steal(size_t self) {
+    for (size_t k = 1; k < pool.n_threads; k++) {
+        worker_queue_t* victim = &pool.queues[(self + k) % pool.n_threads];
+        
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->next;
+        size_t take = (remaining + 1) / 2;
+        size_t end = victim->end;
+        victim->end -= take;
+        pthread_mutex_unlock(&victim->lock);
+        
+        if (take > 0) {
+            worker_queue_t* own = &pool.queues[self];
+            pthread_mutex_lock(&own->lock);
+            own->next = end - take;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_chunk(size_t chunk) {
+    size_t begin = chunk * pool.grain;
+    pool.fn(pool.arg, begin, DDAF_MIN(begin + pool.grain, pool.count));
+}
+
+static void work(size_t self) {
+    size_t chunk;
+    for (;;) {
+        if (take_own(&pool.queues[self], &chunk)) {
+            run_chunk(chunk);
+        } else if (!steal(self)) {
+            return;
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    size_t self = (size_t)(uintptr_t)arg;
+    unsigned long seen = pool.spawn_generation;
+    in_worker = true;
+    worker_index = self;
+    
+    for (;;) {
+        pthread_mutex_lock(&pool.lock);
+        while (!pool.shutdown && pool.generation == seen) {
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        }
+        if (pool.shutdown) {
+            pthread_mutex_unlock(&pool.lock);
+            return NULL;
+        }
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+        
+        work(self);
+        
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0) pthread_cond_signal(&pool.done);
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+static void stop_threads(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = true;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    
+    for (size_t i = 1; i < pool.n_threads; i++) {
+        pthread_join(pool.threads[i], NULL);
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    }
+    
+    pool.shutdown = false;
+    pool.n_threads = 1;
+}
+
+int ddaf_set_num_threads(size_t n_threads) {
+    if (n_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    n_threads = DDAF_MIN(n_threads, (size_t)DDAF_MAX_THREADS);
+    if (in_worker) return -1;
+    
+    /* Workers read the kernel tables; select them before any task runs */
+    ddaf_get_isa();
+    
+    pthread_mutex_lock(&pool.job_lock);
+    stop_threads();
+    
+    pool.spawn_generation = pool.generation;
+    
+    int ret = 0;
+    size_t started = 1;
+    for (; started < n_threads; started++) {
+        pthread_mutex_init(&pool.queues[started].lock, NULL);
+        if (pthread_create(&pool.threads[started], NULL, worker_main,
+                           (void*)(uintptr_t)started) != 0) {
+            pthread_mutex_destroy(&pool.queues[started].lock);
+            ret = -1;
+            break;
+        }
+    }
+    pool.n_threads = started;
+    
+    pthread_mutex_unlock(&pool.job_lock);
+    return ret;
+}
+
+size_t ddaf_get_num_threads(void) {
+    return pool.n_threads;
+}
+
+size_t ddaf_worker_index(void) {
+    return worker_index;
+}
+
+void ddaf_parallel_for(size_t count, size_t grain, ddaf_task_fn fn, void* arg) {
+    if (count == 0) return;
+    size_t n_chunks = (count + grain - 1) / grain;
+    
+    /*
+     * Inline: one chunk, no helpers, a nested call, or another thread's
+     * job in flight. Chunk boundaries are the same either way.
+     */
+    if (n_chunks == 1 || pool.n_threads == 1 || in_worker ||
+        pthread_mutex_trylock(&pool.job_lock) != 0) {
+        for (size_t begin = 0; begin < count; begin += grain) {
+            fn(arg, begin, DDAF_MIN(begin + grain, count));
+        }
+        return;
+    }
+    
+    size_t n_threads = DDAF_MIN(pool.n_threads, n_chunks);
+    for (size_t w = 0; w < pool.n_threads; w++) {
+        worker_queue_t* queue = &pool.queues[w];
+        pthread_mutex_lock(&queue->lock);
+        queue->next = w < n_threads ? w * n_chunks / n_threads : 0;
+        queue->end = w < n_threads ? (w + 1) * n_chunks / n_threads : 0;
+        pthread_mutex_unlock(&queue->lock);
+    }
+    
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.count = count;
+    pool.grain = grain;
+    pool.active = pool.n_threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    
+    in_worker = true;
+    work(0);
+    in_worker = false;
+    
+    pthread_mutex_lock(&pool.lock);
+    while (pool.active > 0) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    
+    pthread_mutex_unlock(&pool.job_lock);
+}
+
+typedef struct {
+    ddaf_block_fn block;
+    void* arg;
+    const float* input;
+    float* output;
+    const uint16_t* input16;
+    uint16_t* output16;
+    ddaf_dtype_t dtype;
+} sweep_t;
+
+static void sweep_task(void* arg, size_t begin, size_t end) {
+    sweep_t* sweep = (sweep_t*)arg;
+    
+    for (size_t start = begin; start < end; start += DDAF_KERNEL_BLOCK) {
+        size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, end - start);
+        sweep->block(sweep->arg, sweep->input + start, sweep->output + start,
+                     start, n);
+    }
+}
+
+static void sweep16_task(void* arg, size_t begin, size_t end) {
+    sweep_t* sweep = (sweep_t*)arg;
+    float block[DDAF_KERNEL_BLOCK];
+    
+    for (size_t start = begin; start < end; start += DDAF_KERNEL_BLOCK) {
+        size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, end - start);
+        ddaf_widen(sweep->dtype, sweep->input16 + start, block, n);
+        sweep->block(sweep->arg, block, block, start, n);
+        ddaf_narrow(sweep->dtype, block, sweep->output16 + start, n);
+    }
+}
+
+void ddaf_parallel_sweep(size_t size, ddaf_block_fn block, void* arg,
+                         const float* input, float* output) {
+    sweep_t sweep = { block, arg, input, output, NULL, NULL, DDAF_DTYPE_F16 };
+    ddaf_parallel_for(size, DDAF_PARALLEL_GRAIN, sweep_task, &sweep);
+}
+
+void ddaf_parallel_sweep16(size_t size, ddaf_block_fn block, void* arg,
+                           const uint16_t* input, uint16_t* output,
+                           ddaf_dtype_t dtype) {
+    sweep_t sweep = { block, arg, NULL, NULL, input, output, dtype };
+    ddaf_parallel_for(size, DDAF_PARALLEL_GRAIN, sweep16_task, &sweep);
+}
+
+typedef struct {
+    ddaf_sample_fn fn;
+    void* arg;
+    size_t sample_size;
+    size_t chunks;                  /* Chunks per sample */
+} samples_t;
+
+static void samples_task(void* arg, size_t begin, size_t end) {
+    const samples_t* samples = (const samples_t*)arg;
+    
+    for (size_t unit = begin; unit < end; unit++) {
+        size_t start = (unit % samples->chunks) * DDAF_PARALLEL_GRAIN;
+        samples->fn(samples->arg, unit / samples->chunks, start,
+                    DDAF_MIN(start + DDAF_PARALLEL_GRAIN, samples->sample_size));
+    }
+}
+
+void ddaf_parallel_samples(size_t batch, size_t sample_size, ddaf_sample_fn fn,
+                           void* arg) {
+    if (sample_size == 0) return;
+    
+    samples_t samples = { fn, arg, sample_size,
+                          (sample_size + DDAF_PARALLEL_GRAIN - 1) /
+                          DDAF_PARALLEL_GRAIN };
+    size_t grain = samples.chunks > 1 ? 1 :
+                   DDAF_MAX(DDAF_PARALLEL_GRAIN / sample_size, (size_t)1);
+    ddaf_parallel_for(batch * samples.chunks, grain, samples_task, &samples);
+}
+
+typedef struct {
+    ddaf_block_fn block;
+    char* args;
+    size_t arg_stride;
+    const float* input;
+    float* output;
+    size_t sample_size;
+} batch_sweep_t;
+
+static void batch_sweep_sample(void* arg, size_t sample, size_t begin,
+                               size_t end) {
+    const batch_sweep_t* sweep = (const batch_sweep_t*)arg;
+    size_t offset = sample * sweep->sample_size;
+    void* block_arg = sweep->args + sample * sweep->arg_stride;
+    
+    for (size_t start = begin; start < end; start += DDAF_KERNEL_BLOCK) {
+        size_t n = DDAF_MIN(DDAF_KERNEL_BLOCK, end - start);
+        sweep->block(block_arg, sweep->input + offset + start,
+                     sweep->output + offset + start, start, n);
+    }
+}
+
+void ddaf_parallel_sweep_batched(size_t batch, size_t sample_size,
+                                 ddaf_block_fn block, void* args,
+                                 size_t arg_stride, const float* input,
+                                 float* output) {
+    batch_sweep_t sweep = { block, (char*)args, arg_stride, input, output,
+                            sample_size };
+    ddaf_parallel_samples(batch, sample_size, batch_sweep_sample, &sweep);
+}